@@ -0,0 +1,136 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "corpus.hpp"
+
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+using namespace standardese_bench;
+
+namespace
+{
+bool is_excluded(const corpus_config& config, unsigned entity)
+{
+    return config.exclude_every != 0u && entity % config.exclude_every == config.exclude_every - 1u;
+}
+
+bool has_unique_name(const corpus_config& config, unsigned entity)
+{
+    return config.unique_name_every != 0u && entity % config.unique_name_every == 0u;
+}
+
+std::string function_name(unsigned header, unsigned entity)
+{
+    return "h" + std::to_string(header) + "_func" + std::to_string(entity);
+}
+
+// the name used to link to the function
+std::string link_name(const corpus_config& config, unsigned header, unsigned entity)
+{
+    if (has_unique_name(config, entity))
+        return function_name(header, entity) + "_unique";
+    else
+        return "bench::" + function_name(header, entity);
+}
+
+const char* const words[] = {"the",   "function", "returns", "value",    "of",   "an", "entity",
+                             "which", "is",       "used",    "together", "with", "a",  "range"};
+
+void write_text(std::ostream& out, std::minstd_rand& rng, const char* indent, unsigned lines)
+{
+    for (auto line = 0u; line != lines; ++line)
+    {
+        out << indent << "///";
+        for (auto i = 0u; i != 10u; ++i)
+            out << ' ' << words[rng() % (sizeof(words) / sizeof(words[0]))];
+        out << ".\n";
+    }
+}
+
+void write_links(std::ostream& out, const corpus_config& config, std::minstd_rand& rng)
+{
+    if (config.entities == 0u)
+        return;
+
+    for (auto i = 0u; i != config.links; ++i)
+    {
+        auto header = unsigned(rng() % config.no_headers);
+        auto entity = unsigned(rng() % config.entities);
+        // excluded functions can't be linked
+        while (is_excluded(config, entity))
+            entity = (entity + 1u) % config.entities;
+        out << "/// See [" << link_name(config, header, entity) << "]().\n";
+    }
+}
+} // namespace
+
+std::string standardese_bench::header_name(unsigned index)
+{
+    return "standardese_bench_" + std::to_string(index) + ".hpp";
+}
+
+std::string standardese_bench::generate_header(const corpus_config& config, unsigned index)
+{
+    // seeded per header, so a header doesn't depend on the number of headers before it
+    std::minstd_rand rng(config.seed * 65521u + index + 1u);
+
+    std::ostringstream out;
+    out << "/// \\file\n";
+    write_text(out, rng, "", config.comment_lines);
+    out << '\n';
+    if (index > 0u)
+        out << "#include \"" << header_name(index - 1u) << "\"\n\n";
+
+    out << "namespace bench\n{\n";
+    for (auto entity = 0u; entity != config.entities; ++entity)
+    {
+        out << "/// \\brief " << function_name(index, entity) << ".\n";
+        write_text(out, rng, "", config.comment_lines);
+        write_links(out, config, rng);
+        if (is_excluded(config, entity))
+            out << "/// \\exclude\n";
+        else if (has_unique_name(config, entity))
+            out << "/// \\unique_name " << link_name(config, index, entity) << '\n';
+        out << "void " << function_name(index, entity) << "(int a, const char* b);\n\n";
+    }
+
+    out << "/// A class with member groups.\n";
+    out << "class h" << index << "_class\n{\npublic:\n";
+    for (auto group = 0u; group != config.member_groups; ++group)
+    {
+        if (group > 0u)
+            out << '\n';
+        // group names are global
+        out << "    /// \\group h" << index << "_g" << group << " Group " << group << '\n';
+        write_text(out, rng, "    ", config.comment_lines);
+        out << "    int get" << group << "(int) const;\n\n";
+        out << "    /// \\group h" << index << "_g" << group << '\n';
+        out << "    int get" << group << "(float) const;\n";
+    }
+    out << "};\n";
+    out << "} // namespace bench\n";
+
+    return out.str();
+}
+
+std::vector<std::string> standardese_bench::write_corpus(const corpus_config& config)
+{
+    if (config.no_headers == 0u)
+        throw std::invalid_argument("the corpus needs at least one header");
+
+    std::vector<std::string> result;
+    for (auto i = 0u; i != config.no_headers; ++i)
+    {
+        result.push_back(header_name(i));
+
+        std::ofstream file(result.back());
+        if (!file.is_open())
+            throw std::runtime_error("unable to write '" + result.back() + "'");
+        file << generate_header(config, i);
+    }
+    return result;
+}
@@ -0,0 +1,37 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
+#define STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+
+namespace standardese_bench
+{
+// the shape of a synthetic project
+struct corpus_config
+{
+    unsigned no_headers        = 50u;
+    unsigned entities          = 20u; // functions per header
+    unsigned comment_lines     = 3u;  // lines of text in each comment
+    unsigned member_groups     = 2u;  // member groups in the class of each header
+    unsigned exclude_every     = 10u; // every n-th function is excluded, 0 for none
+    unsigned unique_name_every = 5u;  // every n-th function has a unique name, 0 for none
+    unsigned links             = 1u;  // links to functions of other headers in each comment
+    unsigned seed              = 0u;  // seed for choosing the link destinations
+};
+
+// returns the source code of the header with the given index
+// each header includes the previous one, so the synopsis refers to other files
+std::string generate_header(const corpus_config& config, unsigned index);
+
+// returns the file name of the header with the given index
+std::string header_name(unsigned index);
+
+// writes all headers into the current working directory and returns their file names
+std::vector<std::string> write_corpus(const corpus_config& config);
+} // namespace standardese_bench
+
+#endif // STANDARDESE_BENCHMARK_CORPUS_HPP_INCLUDED
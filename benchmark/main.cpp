@@ -0,0 +1,260 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <cppast/libclang_parser.hpp>
+#include <cppast/visitor.hpp>
+
+#include <standardese/comment.hpp>
+#include <standardese/doc_entity.hpp>
+#include <standardese/linker.hpp>
+#include <standardese/markup/document.hpp>
+#include <standardese/markup/generator.hpp>
+
+#include "corpus.hpp"
+#include "executor.hpp"
+
+namespace
+{
+struct bench_options
+{
+    standardese_bench::corpus_config corpus;
+    unsigned                         jobs = standardese_tool::default_no_threads();
+    bool                             csv  = false;
+};
+
+void print_usage(const char* exe)
+{
+    std::cout << "Usage: " << exe << " [options]\n\n"
+              << "Generates a synthetic project in the current directory and measures the\n"
+              << "throughput of each phase of the documentation generation.\n\n"
+              << "Options:\n"
+              << "  --headers=N        number of headers, at least 1 (default 50)\n"
+              << "  --entities=N       functions per header (default 20)\n"
+              << "  --comment-lines=N  lines of text in each comment (default 3)\n"
+              << "  --groups=N         member groups per header (default 2)\n"
+              << "  --exclude=N        exclude every N-th function (N > 1), 0 for none "
+                 "(default 10)\n"
+              << "  --unique-name=N    give every N-th function a unique name, 0 for none "
+                 "(default 5)\n"
+              << "  --links=N          cross-links in each comment (default 1)\n"
+              << "  --seed=N           seed for the link destinations (default 0)\n"
+              << "  --jobs=N           number of threads (default: number of cores)\n"
+              << "  --csv              prints the results as CSV\n";
+}
+
+bench_options parse_options(int argc, char* argv[])
+{
+    bench_options result;
+    for (auto i = 1; i != argc; ++i)
+    {
+        std::string arg(argv[i]);
+        if (arg == "--help")
+        {
+            print_usage(argv[0]);
+            std::exit(0);
+        }
+        else if (arg == "--csv")
+        {
+            result.csv = true;
+            continue;
+        }
+
+        auto sep = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || sep == std::string::npos)
+            throw std::invalid_argument("invalid argument '" + arg + "'");
+        auto name  = arg.substr(2, sep - 2);
+        auto value = unsigned(std::stoul(arg.substr(sep + 1)));
+
+        if (name == "headers")
+            result.corpus.no_headers = value;
+        else if (name == "entities")
+            result.corpus.entities = value;
+        else if (name == "comment-lines")
+            result.corpus.comment_lines = value;
+        else if (name == "groups")
+            result.corpus.member_groups = value;
+        else if (name == "exclude")
+            result.corpus.exclude_every = value;
+        else if (name == "unique-name")
+            result.corpus.unique_name_every = value;
+        else if (name == "links")
+            result.corpus.links = value;
+        else if (name == "seed")
+            result.corpus.seed = value;
+        else if (name == "jobs")
+            result.jobs = value == 0u ? 1u : value;
+        else
+            throw std::invalid_argument("unknown option '" + name + "'");
+    }
+
+    // the links need a header to link to and a function that isn't excluded
+    if (result.corpus.no_headers == 0u)
+        throw std::invalid_argument("--headers must be at least 1");
+    else if (result.corpus.exclude_every == 1u)
+        throw std::invalid_argument("--exclude=1 would exclude every function, use 0 for none");
+    return result;
+}
+
+// measures the duration of the phases
+class phase_timer
+{
+public:
+    struct phase
+    {
+        const char* name;
+        double      seconds;
+    };
+
+    void run(const char* name, const std::function<void()>& f)
+    {
+        auto start = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        phases_.push_back({name, std::chrono::duration<double>(end - start).count()});
+    }
+
+    const std::vector<phase>& phases() const noexcept
+    {
+        return phases_;
+    }
+
+private:
+    std::vector<phase> phases_;
+};
+
+void print_results(const bench_options& options, const phase_timer& timer, std::size_t no_files,
+                   std::size_t no_entities)
+{
+    auto total = 0.0;
+    for (auto& phase : timer.phases())
+        total += phase.seconds;
+
+    auto print = [&](const char* name, double seconds) {
+        auto files_per_second    = seconds > 0.0 ? double(no_files) / seconds : 0.0;
+        auto entities_per_second = seconds > 0.0 ? double(no_entities) / seconds : 0.0;
+        if (options.csv)
+            std::cout << name << ',' << options.jobs << ',' << no_files << ',' << no_entities
+                      << ',' << seconds << ',' << files_per_second << ',' << entities_per_second
+                      << '\n';
+        else
+            std::cout << std::left << std::setw(12) << name << std::right << std::setw(12)
+                      << seconds << std::setw(14) << files_per_second << std::setw(14)
+                      << entities_per_second << '\n';
+    };
+
+    std::cout << std::fixed << std::setprecision(3);
+    if (options.csv)
+        std::cout << "phase,jobs,files,entities,seconds,files_per_second,entities_per_second\n";
+    else
+        std::cout << no_files << " files, " << no_entities << " entities, " << options.jobs
+                  << " threads\n\n"
+                  << std::left << std::setw(12) << "phase" << std::right << std::setw(12)
+                  << "seconds" << std::setw(14) << "files/s" << std::setw(14) << "entities/s"
+                  << '\n';
+
+    for (auto& phase : timer.phases())
+        print(phase.name, phase.seconds);
+    print("total", total);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+try
+{
+    auto options = parse_options(argc, argv);
+    auto names   = standardese_bench::write_corpus(options.corpus);
+
+    standardese_tool::executor exec(options.jobs);
+    phase_timer                timer;
+
+    cppast::libclang_compile_config config;
+    config.set_flags(cppast::cpp_standard::cpp_11);
+    config.fast_preprocessing(true);
+
+    cppast::cpp_entity_index                       index;
+    cppast::libclang_parser                        parser(cppast::default_logger());
+    standardese::file_comment_parser               comment_parser(cppast::default_logger());
+    std::vector<std::unique_ptr<cppast::cpp_file>> files(names.size());
+    timer.run("parse", [&] {
+        exec.parallel_for(files.size(), [&](std::size_t i) {
+            files[i] = parser.parse(index, names[i], config);
+            if (!files[i])
+                throw std::runtime_error("unable to parse '" + names[i] + "'");
+            comment_parser.parse(type_safe::ref(*files[i]));
+        });
+    });
+
+    auto no_entities = std::size_t(0);
+    for (auto& file : files)
+        cppast::visit(*file, [&](const cppast::cpp_entity&, const cppast::visitor_info& info) {
+            if (info.event != cppast::visitor_info::container_entity_exit)
+                ++no_entities;
+            return true;
+        });
+
+    standardese::comment_registry comments;
+    timer.run("comments", [&] { comments = comment_parser.finish(); });
+
+    std::vector<std::unique_ptr<standardese::doc_cpp_file>> doc_files(files.size());
+    timer.run("build", [&] {
+        standardese::entity_blacklist blacklist;
+        exec.parallel_for(files.size(), [&](std::size_t i) {
+            standardese::exclude_entities(comments, index, blacklist, *files[i]);
+        });
+        exec.parallel_for(files.size(), [&](std::size_t i) {
+            standardese::markup::entity_arena arena;
+            doc_files[i] = standardese::build_doc_entities(type_safe::ref(comments), index,
+                                                           std::move(files[i]), names[i]);
+        });
+    });
+
+    standardese::linker                                                linker;
+    std::vector<std::unique_ptr<standardese::markup::document_entity>> docs(doc_files.size());
+    timer.run("generate", [&] {
+        standardese::generation_config gen_config;
+        standardese::synopsis_config   syn_config;
+        exec.parallel_for(doc_files.size(), [&](std::size_t i) {
+            standardese::markup::entity_arena         arena;
+            standardese::markup::subdocument::builder document(doc_files[i]->output_name(),
+                                                               "doc_" + names[i]);
+            document.add_child(
+                standardese::generate_documentation(gen_config, syn_config, index, *doc_files[i]));
+            docs[i] = document.finish();
+        });
+    });
+
+    timer.run("link", [&] {
+        for (auto& doc : docs)
+            standardese::register_documentations(*cppast::default_logger(), linker, *doc);
+        linker.freeze();
+        exec.parallel_for(docs.size(), [&](std::size_t i) {
+            standardese::resolve_links(*cppast::default_logger(), linker, *docs[i]);
+        });
+    });
+
+    timer.run("render", [&] {
+        auto generator = standardese::markup::html_generator("", "html");
+        exec.parallel_for(docs.size(), [&](std::size_t i) {
+            standardese::markup::string_output out;
+            generator(out, *docs[i]);
+        });
+    });
+
+    print_results(options, timer, names.size(), no_entities);
+    return 0;
+}
+catch (std::exception& ex)
+{
+    std::cerr << "error: " << ex.what() << '\n';
+    return 1;
+}
@@ -50,6 +50,10 @@ public:
     type_safe::optional_ref<const comment::doc_comment> get_comment(
         const std::string& module_name) const;
 
+    /// \returns The name of the file containing the comment of an entity,
+    /// if it has been registered by a remote comment.
+    type_safe::optional_ref<const std::string> get_remote_file(const cppast::cpp_entity& e) const;
+
     /// \effects Adds an entity to the group of the given name.
     void add_to_group(std::string name, type_safe::object_ref<const cppast::cpp_entity> entity)
     {
@@ -66,11 +70,26 @@ public:
         return type_safe::ref(iter->second.data(), iter->second.size());
     }
 
+    /// \returns The number of entities and modules with a comment.
+    std::size_t no_comments() const noexcept
+    {
+        return map_.size() + modules_.size();
+    }
+
+    /// \returns The number of member groups.
+    std::size_t no_groups() const noexcept
+    {
+        return groups_.size();
+    }
+
 private:
     std::unordered_map<const cppast::cpp_entity*, comment::doc_comment> map_;
     std::unordered_map<std::string, std::vector<type_safe::object_ref<const cppast::cpp_entity>>>
                                                           groups_;
     std::unordered_map<std::string, comment::doc_comment> modules_;
+    std::unordered_map<const cppast::cpp_entity*, std::string> remote_files_;
+
+    friend class file_comment_parser;
 };
 
 /// \returns The unique name of the given entity.
@@ -91,6 +110,8 @@ public:
     void parse(type_safe::object_ref<const cppast::cpp_file> file) const;
 
     /// \effects Finishes parsing of the comments.
+    /// It matches the module and remote entity comments,
+    /// in an order that does not depend on the order the files have been parsed in.
     /// \returns The registry containing all registered comments.
     /// \requires This function must only be called once,
     /// and you must not call `parse()` afterwards.
@@ -114,7 +135,14 @@ private:
     mutable std::mutex                                                      mutex_;
     mutable std::unordered_multimap<std::string, const cppast::cpp_entity*> uncommented_;
     mutable comment_registry                                                registry_;
-    mutable std::vector<comment::parse_result>                              free_comments_;
+    struct free_comment
+    {
+        std::string           file;
+        unsigned              line;
+        comment::parse_result result;
+    };
+
+    mutable std::vector<free_comment>                                       free_comments_;
 
     comment::config                                        config_;
     type_safe::object_ref<const cppast::diagnostic_logger> logger_;
@@ -181,6 +181,15 @@ public:
 
     virtual ~doc_entity() = default;
 
+    /// \effects Allocates the memory of an entity from the [standardese::markup::entity_arena]()
+    /// of the current thread, or from the global allocator if there is none.
+    /// \notes See [standardese::markup::entity::operator new]().
+    static void* operator new(std::size_t size);
+
+    /// \effects Frees the memory of an entity,
+    /// memory of an arena is only freed together with the arena.
+    static void operator delete(void* ptr) noexcept;
+
     /// \returns Whether or not that entity is excluded.
     /// \notes If that is the case, the dynamic type will be [standardese::doc_excluded_entity]().
     bool is_excluded() const noexcept;
@@ -203,6 +212,13 @@ public:
 
     /// \returns The link name of the entity.
     const std::string& link_name() const noexcept
+    {
+        return link_name_.as_str();
+    }
+
+    /// \returns The link name of the entity as an id.
+    /// \notes The link name is interned, so this is cheaper than creating an id from it.
+    const markup::block_id& link_id() const noexcept
     {
         return link_name_;
     }
@@ -322,7 +338,7 @@ private:
     /// \exclude
     virtual void do_generate_code(cppast::code_generator& generator) const = 0;
 
-    std::string                                         link_name_;
+    markup::block_id                                    link_name_;
     std::vector<std::unique_ptr<doc_entity>>            children_;
     type_safe::optional_ref<const doc_entity>           parent_;
     type_safe::optional_ref<const comment::doc_comment> comment_;
@@ -443,7 +459,7 @@ private:
         if (in_member_group() || !comment())
             return parent().value().get_documentation_id();
         else
-            return markup::block_id(link_name());
+            return link_id();
     }
 
     std::unique_ptr<markup::documentation_entity> do_generate_documentation(
@@ -561,7 +577,7 @@ private:
 
     markup::block_id do_get_id() const override
     {
-        return markup::block_id(begin()->link_name());
+        return begin()->link_id();
     }
 
     std::unique_ptr<markup::documentation_entity> do_generate_documentation(
@@ -616,7 +632,7 @@ private:
 
     markup::block_id do_get_id() const override
     {
-        return markup::block_id(link_name());
+        return link_id();
     }
 
     std::unique_ptr<markup::documentation_entity> do_generate_documentation(
@@ -679,7 +695,7 @@ private:
 
     markup::block_id do_get_id() const override
     {
-        return markup::block_id(link_name());
+        return link_id();
     }
 
     std::unique_ptr<markup::documentation_entity> do_generate_documentation(
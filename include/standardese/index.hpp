@@ -7,6 +7,7 @@
 
 #include <memory>
 #include <mutex>
+#include <unordered_map>
 #include <vector>
 
 #include <type_safe/reference.hpp>
@@ -67,23 +68,26 @@ private:
     struct entity
     {
         std::string name, scope;
+        std::string key; // scope + name
         type_safe::variant<std::unique_ptr<markup::entity_index_item>,
                            markup::namespace_documentation::builder>
             doc;
 
         entity(std::unique_ptr<markup::entity_index_item> doc, std::string name, std::string scope)
-        : name(std::move(name)), scope(std::move(scope)), doc(std::move(doc))
+        : name(std::move(name)), scope(std::move(scope)), key(this->scope + this->name),
+          doc(std::move(doc))
         {}
 
         entity(markup::namespace_documentation::builder doc, std::string name, std::string scope)
-        : name(std::move(name)), scope(std::move(scope)), doc(std::move(doc))
+        : name(std::move(name)), scope(std::move(scope)), key(this->scope + this->name),
+          doc(std::move(doc))
         {}
     };
 
     void insert(entity e) const;
 
     mutable std::mutex          mutex_;
-    mutable std::vector<entity> entities_; // sorted by scope, then name
+    mutable std::vector<entity> entities_; // in order of registration, sorted by generate()
 };
 
 /// Registers all entities that needs registration.
@@ -119,7 +123,7 @@ private:
     };
 
     mutable std::mutex        mutex_;
-    mutable std::vector<file> files_;
+    mutable std::vector<file> files_; // in order of registration, sorted by generate()
 };
 
 /// An index of all the modules.
@@ -145,8 +149,8 @@ public:
     std::unique_ptr<markup::module_index> generate() const;
 
 private:
-    mutable std::mutex                                         mutex_;
-    mutable std::vector<markup::module_documentation::builder> modules_;
+    mutable std::mutex mutex_;
+    mutable std::unordered_map<std::string, markup::module_documentation::builder> modules_;
 };
 
 class comment_registry;
@@ -5,10 +5,12 @@
 #ifndef STANDARDESE_LINKER_HPP_INCLUDED
 #define STANDARDESE_LINKER_HPP_INCLUDED
 
+#include <array>
 #include <map>
 #include <mutex>
 #include <stdexcept>
 #include <unordered_map>
+#include <vector>
 
 #include <type_safe/variant.hpp>
 
@@ -33,13 +35,17 @@ namespace markup
 class linker
 {
 public:
+    linker() : frozen_(false) {}
+
     void register_external(std::string namespace_name, std::string url);
 
     /// \effects Registers the given documentation under a certain name.
     /// All unresolved links with that name will resolve to the given documentation.
     /// If `force` is `true`, it will replace a previous registered documentation.
     /// \returns `false` if the link name was used twice.
-    /// \notes This function is thread safe.
+    /// \requires The linker must not be frozen.
+    /// \notes This function is thread safe,
+    /// the long and the short link name are registered together.
     bool register_documentation(std::string link_name, const markup::document_entity& document,
                                 const markup::block_id& documentation, bool force = false) const;
 
@@ -49,13 +55,90 @@ public:
         lookup_documentation(type_safe::optional_ref<const cppast::cpp_entity> context,
                              std::string                                       link_name) const;
 
+    /// \returns A reference to the documentation for the given link name, if there is any.
+    /// Relative link names are looked up in the given scope, as returned by
+    /// [standardese::get_link_scope](), and then in each of its parents.
+    /// \notes This function is thread safe.
+    type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>
+        lookup_documentation(const std::vector<std::string>& scope, std::string link_name) const;
+
+    /// The scope relative link names are looked up in.
+    ///
+    /// It stores the prefix of each level of the scope and caches the lookup results,
+    /// so it should be reused for all links in the same scope.
+    /// \notes It is not thread safe, each thread needs its own context.
+    class lookup_context
+    {
+    public:
+        /// \effects Creates a context without a scope,
+        /// relative link names are not resolved.
+        lookup_context() : has_scope_(false) {}
+
+        /// \effects Creates a context for the given scope,
+        /// as returned by [standardese::get_link_scope]().
+        explicit lookup_context(const std::vector<std::string>& scope);
+
+    private:
+        std::string              prefix_;      // all scopes, each followed by `::`
+        std::vector<std::size_t> prefix_ends_; // the end of the prefix of each level
+        std::unordered_map<std::string,
+                           type_safe::variant<type_safe::nullvar_t, markup::block_reference,
+                                              markup::url>>
+             results_;
+        bool has_scope_;
+
+        friend linker;
+    };
+
+    /// \returns A reference to the documentation for the given link name, if there is any.
+    /// Relative link names are looked up in the scope of the context.
+    /// \effects If the linker is frozen, the result is cached in the context.
+    /// \notes This function is thread safe, as long as each thread uses its own context.
+    type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>
+        lookup_documentation(lookup_context& context, std::string link_name) const;
+
+    /// \effects Moves all registered documentations into a single read-only table,
+    /// lookups don't need to lock anymore.
+    /// \requires No documentation must be registered afterwards.
+    /// \notes This function is *not* thread safe,
+    /// it must be called after the registration is finished and before the lookups start.
+    void freeze();
+
+    /// \returns Whether or not [*freeze]() has been called.
+    bool is_frozen() const noexcept
+    {
+        return frozen_;
+    }
+
 private:
-    mutable std::mutex                                               mutex_;
-    mutable std::unordered_map<std::string, markup::block_reference> map_;
+    using map = std::unordered_map<std::string, markup::block_reference>;
+
+    // during registration, the names are distributed over multiple maps,
+    // so threads registering different names rarely block each other
+    struct shard
+    {
+        std::mutex mutex;
+        map        names;
+    };
+
+    shard& get_shard(const std::string& name) const;
+
+    type_safe::optional<markup::block_reference> find(const std::string& name) const;
+
+    type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url>
+        lookup_documentation_impl(const lookup_context& context, std::string link_name) const;
+
+    mutable std::array<shard, 32> shards_;
+    map                           frozen_map_;
+    bool                          frozen_;
 
     std::map<std::string, std::string> external_doc_;
 };
 
+/// \returns The names of the scopes the entity is in, outermost first.
+/// Relative links in the documentation of the entity are looked up in them.
+std::vector<std::string> get_link_scope(const cppast::cpp_entity& entity);
+
 /// Registers all documentations in a document.
 /// \effects Registers every [standardese::markup::documentation_entity]() using its link name.
 /// Registers every [cppast::cpp_entity]() that is not documented but would have been documented in
@@ -66,8 +149,10 @@ void register_documentations(const cppast::diagnostic_logger& logger, const link
 /// Resolves all unresolved links in a document.
 /// \effects For all [standardese::markup::documentation_link]() entities that are not yet resolved,
 /// uses the linker to resolve them.
-/// \notes This function is *not* thread safe and must be called after the linker is entirely
-/// populated.
+/// \notes It must be called after the linker is entirely populated.
+/// It is thread safe for different documents,
+/// lookups don't need to lock if the linker is frozen.
+/// It only uses the markup, so the ASTs can already be destroyed.
 void resolve_links(const cppast::diagnostic_logger& logger, const linker& l,
                    const markup::document_entity& document);
 } // namespace standardese
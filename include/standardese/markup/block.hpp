@@ -5,6 +5,8 @@
 #ifndef STANDARDESE_MARKUP_BLOCK_HPP_INCLUDED
 #define STANDARDESE_MARKUP_BLOCK_HPP_INCLUDED
 
+#include <string>
+
 #include <type_safe/optional.hpp>
 
 #include <standardese/markup/entity.hpp>
@@ -13,6 +15,30 @@ namespace standardese
 {
 namespace markup
 {
+    namespace detail
+    {
+        /// A string in the global table of identifiers.
+        struct interned_string
+        {
+            std::string str;
+            std::string escaped; // only set if it needs escaping
+
+            /// \returns The string with all characters that are not allowed in an id escaped.
+            const std::string& output_str() const noexcept
+            {
+                return escaped.empty() ? str : escaped;
+            }
+        };
+
+        /// \returns A reference to the string in the global table of identifiers,
+        /// it is added if it isn't there yet.
+        /// \notes This function is thread-safe, it locks one shard of the table.
+        /// Strings are never removed, so the reference is valid forever,
+        /// but the table keeps every distinct id the process ever created,
+        /// including those of entities that have been renamed or removed since.
+        const interned_string& intern(std::string str);
+    } // namespace detail
+
     /// The file name of a [standardese::markup::document_entity]().
     ///
     /// It can either contain the extension already or need one.
@@ -34,7 +60,7 @@ namespace markup
         /// \returns The name of the file, may or may not contain the extension.
         const std::string& name() const noexcept
         {
-            return name_;
+            return name_->str;
         }
 
         /// \returns Whether or not it needs an extension.
@@ -50,15 +76,19 @@ namespace markup
         }
 
     private:
-        output_name(std::string name, bool need) : name_(std::move(name)), needs_extension_(need) {}
+        output_name(std::string name, bool need)
+        : name_(&detail::intern(std::move(name))), needs_extension_(need)
+        {}
 
-        std::string name_;
-        bool        needs_extension_;
+        const detail::interned_string* name_;
+        bool                           needs_extension_;
     };
 
     /// The id of a [standardese::markup::block_entity]().
     ///
     /// It must be unique and should only consist of alphanumerics or `-`.
+    /// The string is interned, so copying and comparing ids is cheap,
+    /// but creating one from a string needs a lookup in the global table.
     class block_id
     {
     public:
@@ -66,32 +96,38 @@ namespace markup
         explicit block_id() : block_id("") {}
 
         /// \effects Creates it given the string representation.
-        explicit block_id(std::string id) : id_(std::move(id)) {}
+        explicit block_id(std::string id) : id_(&detail::intern(std::move(id))) {}
 
         /// \returns Whether or not the id is empty.
         bool empty() const noexcept
         {
-            return id_.empty();
+            return id_->str.empty();
         }
 
         /// \returns The string representation of the id.
         const std::string& as_str() const noexcept
         {
-            return id_;
+            return id_->str;
         }
 
         /// \returns The escaped string representaton.
-        std::string as_output_str() const;
+        /// \notes It is computed once when the id is interned.
+        const std::string& as_output_str() const noexcept
+        {
+            return id_->output_str();
+        }
 
     private:
-        std::string id_;
+        const detail::interned_string* id_;
+
+        friend bool operator==(const block_id& a, const block_id& b) noexcept;
     };
 
     /// \returns Whether or not two ids are (un-)equal.
     /// \group block_id_equal block_id comparison
     inline bool operator==(const block_id& a, const block_id& b) noexcept
     {
-        return a.as_str() == b.as_str();
+        return a.id_ == b.id_;
     }
 
     /// \group block_id_equal
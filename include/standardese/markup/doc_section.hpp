@@ -5,6 +5,8 @@
 #ifndef STANDARDESE_MARKUP_DOC_SECTION_HPP_INCLUDED
 #define STANDARDESE_MARKUP_DOC_SECTION_HPP_INCLUDED
 
+#include <atomic>
+
 #include <standardese/markup/block.hpp>
 #include <standardese/markup/list.hpp>
 #include <standardese/markup/paragraph.hpp>
@@ -78,6 +80,11 @@ namespace markup
         /// \returns The unique id of the brief section.
         ///
         /// It is created from the parent id.
+        /// \requires It must not be called while another thread adds the section to a parent.
+        /// \notes The id is cached together with the parent id it was created from,
+        /// and the two are updated without a lock.
+        /// Concurrent calls are fine as long as the parent doesn't change,
+        /// as they all store the same id.
         block_id id() const;
 
     private:
@@ -92,7 +99,10 @@ namespace markup
 
         std::unique_ptr<entity> do_clone() const override;
 
-        brief_section() = default;
+        brief_section() : cached_parent_id_(block_id()), cached_id_(block_id()) {}
+
+        // the parent id the cached id was created from, see id() for the thread safety
+        mutable std::atomic<block_id> cached_parent_id_, cached_id_;
     };
 
     /// A `\details` section in an entity documentation.
@@ -7,6 +7,7 @@
 
 #include <type_safe/optional_ref.hpp>
 
+#include <string>
 #include <vector>
 
 #include <standardese/markup/block.hpp>
@@ -92,6 +93,14 @@ namespace markup
             return {sections_.begin(), sections_.end()};
         }
 
+        /// \returns The names of the scopes the documented entity is in, outermost first.
+        /// \notes They are used to resolve relative links,
+        /// so the AST doesn't need to be kept alive for it.
+        const std::vector<std::string>& link_scope() const noexcept
+        {
+            return link_scope_;
+        }
+
     protected:
         documentation_entity(block_id id, type_safe::optional<documentation_header> h,
                              std::unique_ptr<code_block> synopsis) // may be nullptr
@@ -137,6 +146,14 @@ namespace markup
                 return *this;
             }
 
+            /// \effects Sets the scope used to resolve relative links,
+            /// as returned by [standardese::get_link_scope]().
+            documentation_builder& set_link_scope(std::vector<std::string> scope)
+            {
+                this->peek().link_scope_ = std::move(scope);
+                return *this;
+            }
+
             /// \returns The id of the documentation.
             const block_id& id() const noexcept
             {
@@ -168,6 +185,7 @@ namespace markup
         std::vector<std::unique_ptr<doc_section>> sections_;
         type_safe::optional<documentation_header> header_;
         std::unique_ptr<code_block>               synopsis_; // may be nullptr
+        std::vector<std::string>                  link_scope_;
     };
 
     /// A container containing the documentation of a single entity.
@@ -196,6 +214,8 @@ namespace markup
             {}
         };
 
+        /// \returns The documented entity.
+        /// \requires The AST of the entity must still be alive.
         const cppast::cpp_entity& entity() const noexcept
         {
             return *entity_;
@@ -240,6 +260,8 @@ namespace markup
             {}
         };
 
+        /// \returns The documented file.
+        /// \requires The AST of the file must still be alive.
         const cppast::cpp_file& file() const noexcept
         {
             return *file_;
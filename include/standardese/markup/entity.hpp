@@ -5,6 +5,7 @@
 #ifndef STANDARDESE_MARKUP_ENTITY_HPP_INCLUDED
 #define STANDARDESE_MARKUP_ENTITY_HPP_INCLUDED
 
+#include <cstddef>
 #include <memory>
 #include <string>
 #include <type_traits>
@@ -12,6 +13,7 @@
 
 #include <type_safe/optional_ref.hpp>
 
+#include <standardese/markup/entity_arena.hpp>
 #include <standardese/markup/visitor.hpp>
 
 namespace standardese
@@ -37,6 +39,17 @@ namespace markup
         entity& operator=(const entity&) = delete;
         virtual ~entity() noexcept       = default;
 
+        /// \effects Allocates the memory of an entity from the
+        /// [standardese::markup::entity_arena]() of the current thread,
+        /// or from the global allocator if there is none.
+        /// \notes Documentation consists of many small entities,
+        /// the arena avoids the overhead and the contention of the global allocator.
+        static void* operator new(std::size_t size);
+
+        /// \effects Frees the memory of an entity,
+        /// memory of an arena is only freed together with the arena.
+        static void operator delete(void* ptr) noexcept;
+
         /// \returns The kind of entity.
         entity_kind kind() const noexcept
         {
@@ -0,0 +1,49 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_MARKUP_ENTITY_ARENA_HPP_INCLUDED
+#define STANDARDESE_MARKUP_ENTITY_ARENA_HPP_INCLUDED
+
+namespace standardese
+{
+namespace markup
+{
+    /// \exclude
+    namespace detail
+    {
+        struct arena_state;
+    } // namespace detail
+
+    /// An arena the entities of a document are allocated from.
+    ///
+    /// While it is alive, every [standardese::markup::entity]() and [standardese::doc_entity]()
+    /// created on the current thread is carved out of its chunks,
+    /// and freeing one of them doesn't return its memory.
+    /// The chunks are freed all at once when the arena and all entities allocated from it
+    /// are destroyed, usually that is when the document built with it is destroyed.
+    /// \notes An entity that outlives its document keeps the chunks alive,
+    /// so entities can still be moved or freed independently and on any thread.
+    class entity_arena
+    {
+    public:
+        /// \effects Makes it the arena of the current thread until it is destroyed.
+        entity_arena();
+
+        /// \effects Makes the previous arena the arena of the current thread again,
+        /// the chunks are freed if there are no entities left that were allocated from it.
+        /// \requires It must be destroyed on the thread that created it,
+        /// in the reverse order of creation.
+        ~entity_arena() noexcept;
+
+        entity_arena(const entity_arena&) = delete;
+        entity_arena& operator=(const entity_arena&) = delete;
+
+    private:
+        detail::arena_state* state_;
+        detail::arena_state* previous_;
+    };
+} // namespace markup
+} // namespace standardese
+
+#endif // STANDARDESE_MARKUP_ENTITY_ARENA_HPP_INCLUDED
@@ -5,9 +5,13 @@
 #ifndef STANDARDESE_MARKUP_GENERATOR_HPP_INCLUDED
 #define STANDARDESE_MARKUP_GENERATOR_HPP_INCLUDED
 
+#include <cstddef>
 #include <functional>
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <type_traits>
+#include <utility>
 
 namespace standardese
 {
@@ -15,10 +19,180 @@ namespace markup
 {
     class entity;
 
+    /// The output of a [standardese::markup::generator]().
+    ///
+    /// The generators buffer their output and pass it on in big chunks,
+    /// so an implementation doesn't need to buffer small writes itself.
+    class output_sink
+    {
+    public:
+        output_sink(const output_sink&) = delete;
+        output_sink& operator=(const output_sink&) = delete;
+
+        virtual ~output_sink() noexcept = default;
+
+        /// \effects Writes the given characters.
+        void write(const char* str, std::size_t size)
+        {
+            do_write(str, size);
+        }
+
+    protected:
+        output_sink() noexcept = default;
+
+    private:
+        virtual void do_write(const char* str, std::size_t size) = 0;
+    };
+
+    /// An [standardese::markup::output_sink]() that stores the output in memory.
+    class string_output final : public output_sink
+    {
+    public:
+        /// \effects Creates it reserving memory for the given number of characters.
+        explicit string_output(std::size_t capacity = 0u)
+        {
+            str_.reserve(capacity);
+        }
+
+        /// \returns The output written so far.
+        const std::string& str() const noexcept
+        {
+            return str_;
+        }
+
+        /// \returns The output written so far, moved out of the object.
+        /// \effects Afterwards it is empty and can be written to again.
+        std::string release() noexcept
+        {
+            auto result = std::move(str_);
+            str_.clear();
+            return result;
+        }
+
+    private:
+        void do_write(const char* str, std::size_t size) override
+        {
+            str_.append(str, size);
+        }
+
+        std::string str_;
+    };
+
+    /// An [standardese::markup::output_sink]() that writes to a `std::ostream`.
+    class stream_output final : public output_sink
+    {
+    public:
+        explicit stream_output(std::ostream& out) noexcept : out_(&out) {}
+
+    private:
+        void do_write(const char* str, std::size_t size) override;
+
+        std::ostream* out_;
+    };
+
+    /// An [standardese::markup::output_sink]() that writes to a file.
+    ///
+    /// It doesn't use `std::ostream`,
+    /// the output is collected in a big buffer and written directly to the file descriptor.
+    class file_output final : public output_sink
+    {
+    public:
+        /// \effects Creates the file or truncates an existing one.
+        /// \throws `std::runtime_error` if the file cannot be opened.
+        explicit file_output(std::string path);
+
+        /// \effects Closes the file, ignoring errors.
+        ~file_output() noexcept override;
+
+        /// \effects Writes the buffered output and closes the file.
+        /// \throws `std::runtime_error` if the output cannot be written.
+        void close();
+
+    private:
+        void do_write(const char* str, std::size_t size) override;
+
+        void flush();
+
+        std::string             path_;
+        std::unique_ptr<char[]> buffer_;
+        std::size_t             size_;
+        int                     fd_;
+    };
+
+    /// \exclude
+    namespace detail
+    {
+        template <typename Fnc>
+        auto is_sink_generator(int)
+            -> decltype(std::declval<Fnc&>()(std::declval<output_sink&>(),
+                                             std::declval<const entity&>()),
+                        std::true_type{});
+
+        template <typename Fnc>
+        std::false_type is_sink_generator(short);
+    } // namespace detail
+
     /// A generator.
     ///
-    /// It will write the entity representation to the given stream.
-    using generator = std::function<void(std::ostream&, const entity&)>;
+    /// It will write the entity representation to the given output.
+    class generator
+    {
+    public:
+        /// \effects Creates an empty generator.
+        generator() noexcept = default;
+
+        /// \effects Creates an empty generator.
+        generator(std::nullptr_t) noexcept {}
+
+        /// \effects Creates it from a function object
+        /// that can be called with `(output_sink&, const entity&)`,
+        /// or with `(std::ostream&, const entity&)` like the generators of previous versions.
+        /// \notes A function object taking a `std::ostream` writes to a stream
+        /// that forwards to the output sink,
+        /// prefer taking the [standardese::markup::output_sink]() directly.
+        template <typename Fnc, typename = typename std::enable_if<!std::is_same<
+                                    typename std::decay<Fnc>::type, generator>::value>::type>
+        generator(Fnc f)
+        : f_(make(std::move(f), decltype(detail::is_sink_generator<Fnc>(0)){}))
+        {}
+
+        /// \effects Writes the representation of the entity to the output.
+        void operator()(output_sink& out, const entity& e) const
+        {
+            f_(out, e);
+        }
+
+        /// \effects Writes the representation of the entity to the stream.
+        /// \notes This goes through the `std::ostream` machinery,
+        /// prefer one of the [standardese::markup::output_sink]() implementations.
+        void operator()(std::ostream& out, const entity& e) const;
+
+        /// \returns Whether or not the generator is not empty.
+        explicit operator bool() const noexcept
+        {
+            return bool(f_);
+        }
+
+    private:
+        using function = std::function<void(output_sink&, const entity&)>;
+
+        template <typename Fnc>
+        static function make(Fnc f, std::true_type)
+        {
+            return function(std::move(f));
+        }
+
+        template <typename Fnc>
+        static function make(Fnc f, std::false_type)
+        {
+            return from_stream_generator(std::move(f));
+        }
+
+        static function from_stream_generator(
+            std::function<void(std::ostream&, const entity&)> f);
+
+        function f_;
+    };
 
     /// Renders an entity to a string.
     ///
@@ -142,6 +142,8 @@ namespace markup
             using container_builder::add_child;
         };
 
+        /// \returns The documented namespace.
+        /// \requires The AST of the namespace must still be alive.
         const cppast::cpp_namespace& namespace_() const noexcept
         {
             return *ns_;
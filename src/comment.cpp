@@ -9,6 +9,7 @@
 #include <cppast/visitor.hpp>
 
 #include <algorithm>
+#include <unordered_set>
 
 #include "get_special_entity.hpp"
 
@@ -22,6 +23,8 @@ void comment_registry::merge(comment_registry&& other)
                    std::make_move_iterator(other.groups_.end()));
     modules_.insert(std::make_move_iterator(other.modules_.begin()),
                     std::make_move_iterator(other.modules_.end()));
+    remote_files_.insert(std::make_move_iterator(other.remote_files_.begin()),
+                         std::make_move_iterator(other.remote_files_.end()));
 }
 
 bool comment_registry::register_comment(type_safe::object_ref<const cppast::cpp_entity> entity,
@@ -74,6 +77,21 @@ type_safe::optional_ref<const comment::doc_comment> comment_registry::get_commen
     return type_safe::ref(iter->second);
 }
 
+type_safe::optional_ref<const std::string> comment_registry::get_remote_file(
+    const cppast::cpp_entity& e) const
+{
+    const cppast::cpp_entity* entity = &e;
+    if (cppast::is_friended(*entity))
+        entity = &entity->parent().value();
+    if (cppast::is_templated(*entity))
+        entity = &entity->parent().value();
+
+    auto iter = remote_files_.find(entity);
+    if (iter == remote_files_.end())
+        return type_safe::nullopt;
+    return type_safe::ref(iter->second);
+}
+
 namespace
 {
 cppast::source_location make_location(const cppast::cpp_entity&   entity,
@@ -242,24 +260,13 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
                 logger_->log("standardese comment",
                              make_semantic_diagnostic(*file, "multiple file comments"));
         }
-        else if (auto module = comment::get_module(comment.entity))
-        {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto                         result
-                = registry_.register_comment(module.value(), std::move(comment.comment.value()));
-            lock.unlock();
-
-            if (!result)
-                logger_->log("standardese comment",
-                             make_diagnostic(cppast::source_location::make_file(file->name(),
-                                                                                free.line),
-                                             "multiple comments for module '", module.value(),
-                                             "'"));
-        }
-        else if (auto name = comment::get_remote_entity(comment.entity))
+        else if (comment::get_module(comment.entity) || comment::get_remote_entity(comment.entity))
         {
             assert(comment.comment);
-            free_comments_.push_back(std::move(comment));
+
+            // handled in finish()
+            std::lock_guard<std::mutex> lock(mutex_);
+            free_comments_.push_back({file->name(), free.line, std::move(comment)});
         }
         else
             logger_
@@ -269,30 +276,121 @@ void file_comment_parser::parse(type_safe::object_ref<const cppast::cpp_file> fi
     }
 }
 
+namespace
+{
+const cppast::cpp_file& get_file(const cppast::cpp_entity& e)
+{
+    auto cur = type_safe::ref(e);
+    while (cur->parent())
+        cur = type_safe::ref(cur->parent().value());
+    return static_cast<const cppast::cpp_file&>(*cur);
+}
+
+// the positions of the entities in their file
+// every file is only visited once, no matter how many entities of it are sorted
+class entity_positions
+{
+public:
+    void add_file(const cppast::cpp_file& file)
+    {
+        if (!files_.insert(&file).second)
+            // already visited
+            return;
+
+        auto position = std::size_t(0);
+        cppast::visit(file, [&](const cppast::cpp_entity& e, const cppast::visitor_info& info) {
+            if (info.event != cppast::visitor_info::container_entity_exit)
+                positions_.emplace(&e, position++);
+            return true;
+        });
+    }
+
+    std::size_t get(const cppast::cpp_entity* e) const
+    {
+        auto iter = positions_.find(e);
+        // inline entities aren't visited
+        return iter == positions_.end() ? std::size_t(-1) : iter->second;
+    }
+
+private:
+    std::unordered_set<const cppast::cpp_file*>                files_;
+    std::unordered_map<const cppast::cpp_entity*, std::size_t> positions_;
+};
+
+// sorts the entities by file name and position in the file
+void sort_by_position(std::vector<const cppast::cpp_entity*>& entities,
+                      entity_positions&                       positions)
+{
+    if (entities.size() <= 1u)
+        return;
+
+    for (auto entity : entities)
+        positions.add_file(get_file(*entity));
+
+    std::stable_sort(entities.begin(), entities.end(),
+                     [&](const cppast::cpp_entity* a, const cppast::cpp_entity* b) {
+                         auto& file_a = get_file(*a).name();
+                         auto& file_b = get_file(*b).name();
+                         if (file_a != file_b)
+                             return file_a < file_b;
+                         return positions.get(a) < positions.get(b);
+                     });
+}
+} // namespace
+
 comment_registry file_comment_parser::finish()
 {
-    // find suitable entities for the free comments
+    // the order the free comments have been added depends on the order the files were parsed in
+    std::stable_sort(free_comments_.begin(), free_comments_.end(),
+                     [](const free_comment& a, const free_comment& b) {
+                         if (a.file != b.file)
+                             return a.file < b.file;
+                         return a.line < b.line;
+                     });
+
+    entity_positions positions;
     for (auto& free : free_comments_)
     {
-        auto result = uncommented_.equal_range(comment::get_remote_entity(free.entity).value());
+        if (auto module = comment::get_module(free.result.entity))
+        {
+            if (!registry_.register_comment(module.value(),
+                                            std::move(free.result.comment.value())))
+                logger_->log("standardese comment",
+                             make_diagnostic(cppast::source_location::make_file(free.file,
+                                                                                free.line),
+                                             "multiple comments for module '", module.value(),
+                                             "'"));
+            continue;
+        }
+
+        // find suitable entities for the remote comments
+        auto name   = comment::get_remote_entity(free.result.entity).value();
+        auto result = uncommented_.equal_range(name);
         if (result.first != result.second)
         {
-            auto metadata = free.comment.value().metadata();
+            std::vector<const cppast::cpp_entity*> entities;
+            for (auto cur = result.first; cur != result.second; ++cur)
+                entities.push_back(cur->second);
+            sort_by_position(entities, positions);
 
-            register_commented(type_safe::ref(*result.first->second),
-                               std::move(free.comment.value()), false);
+            auto metadata = free.result.comment.value().metadata();
 
-            for (auto cur = std::next(result.first); cur != result.second; ++cur)
-                register_commented(type_safe::ref(*cur->second),
+            register_commented(type_safe::ref(*entities.front()),
+                               std::move(free.result.comment.value()), false);
+
+            for (auto cur = std::next(entities.begin()); cur != entities.end(); ++cur)
+                register_commented(type_safe::ref(**cur),
                                    comment::doc_comment(metadata, nullptr, {}), false);
 
+            for (auto entity : entities)
+                registry_.remote_files_.emplace(entity, free.file);
+
             uncommented_.erase(result.first, result.second);
         }
         else
             logger_->log("standardese comment",
                          make_diagnostic(cppast::source_location(),
-                                         "unable to find matching entity '",
-                                         comment::get_remote_entity(free.entity).value(),
+                                         "unable to find matching entity '", name,
                                          "' for comment"));
     }
 
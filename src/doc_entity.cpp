@@ -21,6 +21,7 @@
 #include <cppast/visitor.hpp>
 
 #include <standardese/comment.hpp>
+#include <standardese/linker.hpp>
 #include <standardese/markup/entity_kind.hpp>
 #include <standardese/markup/heading.hpp>
 #include <standardese/markup/link.hpp>
@@ -797,7 +798,7 @@ std::unique_ptr<markup::documentation_entity> doc_cpp_entity::do_generate_docume
     auto inline_doc
         = gen_config.is_flag_set(generation_config::inline_doc) && empty_sections(comment());
 
-    if (group_member_no_.value_or(1u) != 1u || get_documentation_id().as_str() != link_name())
+    if (group_member_no_.value_or(1u) != 1u || get_documentation_id() != link_id())
         // not a main entity that needs documentation
         return nullptr;
     // various inline entities
@@ -827,6 +828,7 @@ std::unique_ptr<markup::documentation_entity> doc_cpp_entity::do_generate_docume
                                                       get_header(*entity_, comment(),
                                                                  get_entity_name(true, *entity_)),
                                                       std::move(synopsis));
+        builder.set_link_scope(get_link_scope(*entity_));
         if (comment())
             comment::set_sections(builder, comment().value());
 
@@ -919,6 +921,7 @@ std::unique_ptr<markup::documentation_entity> doc_cpp_namespace::do_generate_doc
                                                       get_header(namespace_(), comment(),
                                                                  namespace_().name()),
                                                       std::move(synopsis));
+        builder.set_link_scope(get_link_scope(*entity_));
         comment::set_sections(builder, comment().value());
 
         return builder.finish();
@@ -928,6 +931,7 @@ std::unique_ptr<markup::documentation_entity> doc_cpp_namespace::do_generate_doc
         // generate empty namespace documentation
         markup::entity_documentation::builder builder(entity_, get_documentation_id(),
                                                       type_safe::nullopt, nullptr);
+        builder.set_link_scope(get_link_scope(*entity_));
         for (auto& doc : child_docs)
             builder.add_child(std::move(doc));
 
@@ -941,6 +945,7 @@ markup::namespace_documentation::builder doc_cpp_namespace::get_builder() const
                                                      get_header(namespace_(), comment(),
                                                                 get_entity_name(true,
                                                                                 namespace_())));
+    builder.set_link_scope(get_link_scope(*entity_));
     if (comment())
         comment::set_sections(builder, comment().value());
     return builder;
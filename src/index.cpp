@@ -6,6 +6,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <cppast/cpp_file.hpp>
 #include <cppast/cpp_namespace.hpp>
 #include <cppast/cpp_preprocessor.hpp>
@@ -24,27 +25,9 @@ using namespace standardese;
 
 void entity_index::insert(entity e) const
 {
+    // sorted once in generate(), instead of on every insertion
     std::lock_guard<std::mutex> lock(mutex_);
-    auto                        range
-        = std::equal_range(entities_.begin(), entities_.end(), e,
-                           [](const entity_index::entity& lhs, const entity_index::entity& rhs) {
-                               return lhs.scope + lhs.name < rhs.scope + rhs.name;
-                           });
-    if (range.first == range.second)
-        entities_.insert(range.first, std::move(e));
-    else
-    {
-        assert(std::next(range.first) == range.second);
-        auto& inserted = *range.first;
-        if (auto builder = inserted.doc.optional_value(
-                type_safe::variant_type<markup::namespace_documentation::builder>{}))
-        {
-            auto& e_builder
-                = e.doc.value(type_safe::variant_type<markup::namespace_documentation::builder>{});
-            if (!builder.value().has_documentation() && e_builder.has_documentation())
-                inserted.doc = std::move(e.doc);
-        }
-    }
+    entities_.push_back(std::move(e));
 }
 
 namespace
@@ -161,7 +144,29 @@ std::unique_ptr<markup::entity_index> entity_index::generate(order o) const
     lists.push_back(nested_list_builder{"", type_safe::ref(builder)});
 
     std::unique_lock<std::mutex> lock(mutex_);
-    for (auto& entity : entities_)
+    // stable, so the first registration of an entity comes first
+    std::stable_sort(entities_.begin(), entities_.end(),
+                     [](const entity& lhs, const entity& rhs) { return lhs.key < rhs.key; });
+
+    std::vector<entity> unique;
+    unique.reserve(entities_.size());
+    for (auto& e : entities_)
+        if (unique.empty() || unique.back().key != e.key)
+            unique.push_back(std::move(e));
+        else if (auto builder = unique.back().doc.optional_value(
+                     type_safe::variant_type<markup::namespace_documentation::builder>{}))
+        {
+            // duplicate namespace, use the first one with documentation
+            auto e_builder = e.doc.optional_value(
+                type_safe::variant_type<markup::namespace_documentation::builder>{});
+            if (e_builder && !builder.value().has_documentation()
+                && e_builder.value().has_documentation())
+                unique.back().doc = std::move(e.doc);
+        }
+    entities_.clear();
+    lock.unlock();
+
+    for (auto& entity : unique)
     {
         // find matching parent
         while (entity.scope != (lists.back().scope.empty() ? "" : lists.back().scope + "::"))
@@ -180,7 +185,6 @@ std::unique_ptr<markup::entity_index> entity_index::generate(order o) const
             lists.back().add_item(std::move(entity.doc.value(
                 type_safe::variant_type<std::unique_ptr<markup::entity_index_item>>{})));
     }
-    lock.unlock();
 
     while (!lists.empty())
     {
@@ -227,12 +231,7 @@ void file_index::register_file(std::string link_name, std::string file_name,
     file_index::file f(file_name, get_entity_entry(file_name, link_name, brief));
 
     std::lock_guard<std::mutex> lock(mutex_);
-    auto                        range = std::equal_range(files_.begin(), files_.end(), f,
-                                  [](const file_index::file& lhs, const file_index::file& rhs) {
-                                      return lhs.name < rhs.name;
-                                  });
-    if (range.first == range.second)
-        files_.insert(range.first, std::move(f));
+    files_.push_back(std::move(f));
 }
 
 std::unique_ptr<markup::file_index> file_index::generate() const
@@ -241,8 +240,13 @@ std::unique_ptr<markup::file_index> file_index::generate() const
         markup::heading::build(markup::block_id(), "Project files"));
 
     std::unique_lock<std::mutex> lock(mutex_);
-    for (auto& file : files_)
-        builder.add_child(std::move(file.doc));
+    // stable, so the first registration of a file comes first
+    std::stable_sort(files_.begin(), files_.end(),
+                     [](const file& lhs, const file& rhs) { return lhs.name < rhs.name; });
+    for (auto iter = files_.begin(); iter != files_.end(); ++iter)
+        if (iter == files_.begin() || std::prev(iter)->name != iter->name)
+            builder.add_child(std::move(iter->doc));
+    files_.clear();
     lock.unlock();
 
     return builder.finish();
@@ -250,27 +254,23 @@ std::unique_ptr<markup::file_index> file_index::generate() const
 
 void module_index::register_module(markup::module_documentation::builder doc) const
 {
+    auto name = doc.id().as_str();
+
     std::lock_guard<std::mutex> lock(mutex_);
-    auto                        range = std::equal_range(modules_.begin(), modules_.end(), doc,
-                                  [](const markup::module_documentation::builder& lhs,
-                                     const markup::module_documentation::builder& rhs) {
-                                      return lhs.id().as_str() < rhs.id().as_str();
-                                  });
-    if (range.first == range.second)
-        modules_.insert(range.first, std::move(doc));
+    modules_.emplace(std::move(name), std::move(doc));
 }
 
 bool module_index::register_entity(std::string module, std::string link_name,
                                    const cppast::cpp_entity&                            entity,
                                    type_safe::optional_ref<const markup::brief_section> brief) const
 {
+    auto entry = get_entity_entry(entity.name(), std::move(link_name), std::move(brief));
+
     std::lock_guard<std::mutex> lock(mutex_);
-    auto                        iter = std::lower_bound(modules_.begin(), modules_.end(), module,
-                                 [](const markup::module_documentation::builder& lhs,
-                                    const std::string& rhs) { return lhs.id().as_str() < rhs; });
-    if (iter == modules_.end() || iter->id().as_str() != module)
+    auto                        iter = modules_.find(module);
+    if (iter == modules_.end())
         return false;
-    iter->add_child(get_entity_entry(entity.name(), std::move(link_name), std::move(brief)));
+    iter->second.add_child(std::move(entry));
     return true;
 }
 
@@ -280,8 +280,19 @@ std::unique_ptr<markup::module_index> module_index::generate() const
         markup::heading::build(markup::block_id(), "Project modules"));
 
     std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<markup::module_documentation::builder*> modules;
+    modules.reserve(modules_.size());
     for (auto& module : modules_)
-        builder.add_child(module.finish());
+        modules.push_back(&module.second);
+    std::sort(modules.begin(), modules.end(),
+              [](const markup::module_documentation::builder* lhs,
+                 const markup::module_documentation::builder* rhs) {
+                  return lhs->id().as_str() < rhs->id().as_str();
+              });
+
+    for (auto module : modules)
+        builder.add_child(module->finish());
+    modules_.clear();
     lock.unlock();
 
     return builder.finish();
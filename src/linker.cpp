@@ -6,6 +6,8 @@
 
 #include <algorithm>
 #include <cassert>
+#include <functional>
+#include <iterator>
 
 #include <cppast/cpp_entity.hpp>
 #include <cppast/cpp_file.hpp>
@@ -97,43 +99,97 @@ std::string short_link_name(const std::string& name)
 }
 } // namespace
 
+linker::shard& linker::get_shard(const std::string& name) const
+{
+    return shards_[std::hash<std::string>{}(name) % shards_.size()];
+}
+
 bool linker::register_documentation(std::string link_name, const markup::document_entity& document,
                                     const markup::block_id& documentation, bool force) const
 {
+    assert(!frozen_);
     auto ref = markup::block_reference(document.output_name(), documentation);
 
-    link_name       = process_link_name(std::move(link_name));
-    auto short_name = short_link_name(link_name);
+    link_name         = process_link_name(std::move(link_name));
+    auto short_name   = short_link_name(link_name);
+    auto insert_short = short_name != link_name;
+
+    // lock the shards of both names in a fixed order,
+    // so concurrent registrations can't interleave between the two inserts
+    auto& long_shard  = get_shard(link_name);
+    auto& short_shard = insert_short ? get_shard(short_name) : long_shard;
+    auto  first       = &long_shard < &short_shard ? &long_shard : &short_shard;
+    auto  last        = &long_shard < &short_shard ? &short_shard : &long_shard;
 
-    std::lock_guard<std::mutex> lock(mutex_);
+    std::unique_lock<std::mutex> first_lock(first->mutex), last_lock;
+    if (last != first)
+        last_lock = std::unique_lock<std::mutex>(last->mutex);
 
     // insert long name
-    auto result = map_.emplace(std::move(link_name), ref);
-    if (!result.second) // not inserted
+    auto long_result = long_shard.names.emplace(std::move(link_name), ref);
+    if (!long_result.second) // not inserted
     {
         if (force)
-            result.first->second = ref; // override anyway
+            long_result.first->second = ref; // override anyway
         else
             return false;
     }
 
     // insert short name
-    if (short_name != result.first->first)
+    if (insert_short)
     {
-        result = map_.emplace(std::move(short_name), ref);
-        if (!result.second)
+        auto short_result = short_shard.names.emplace(std::move(short_name), ref);
+        if (!short_result.second)
         {
             if (force)
-                result.first->second = std::move(ref);
+                short_result.first->second = std::move(ref);
             else
                 // duplicate, erase first one as well
-                map_.erase(result.first);
+                short_shard.names.erase(short_result.first);
         }
     }
 
     return true;
 }
 
+void linker::freeze()
+{
+    if (frozen_)
+        return;
+
+    auto size = std::size_t(0);
+    for (auto& shard : shards_)
+        size += shard.names.size();
+    frozen_map_.reserve(size);
+
+    for (auto& shard : shards_)
+    {
+        frozen_map_.insert(std::make_move_iterator(shard.names.begin()),
+                           std::make_move_iterator(shard.names.end()));
+        map().swap(shard.names);
+    }
+    frozen_ = true;
+}
+
+type_safe::optional<markup::block_reference> linker::find(const std::string& name) const
+{
+    if (frozen_)
+    {
+        // read-only, no need to lock
+        auto iter = frozen_map_.find(name);
+        if (iter == frozen_map_.end())
+            return type_safe::nullopt;
+        return iter->second;
+    }
+
+    auto&                       shard = get_shard(name);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto                        iter = shard.names.find(name);
+    if (iter == shard.names.end())
+        return type_safe::nullopt;
+    return iter->second;
+}
+
 namespace
 {
 bool has_scope(const std::string& str, const std::string& scope)
@@ -163,36 +219,71 @@ std::string get_scope_name(const cppast::cpp_entity& entity)
     auto scope_name = scope.map(&cppast::cpp_scope_name::name);
     return type_safe::copy(scope_name).value_or("");
 }
+} // namespace
 
-std::string get_entity_scope(const cppast::cpp_entity& entity)
+std::vector<std::string> standardese::get_link_scope(const cppast::cpp_entity& entity)
 {
-    std::string result;
+    std::vector<std::string> result;
     for (auto cur = entity.parent(); cur; cur = cur.value().parent())
     {
         auto cur_scope = get_scope_name(cur.value());
         if (!cur_scope.empty())
-            result = cur_scope + "::" + result;
+            result.push_back(std::move(cur_scope));
     }
+    std::reverse(result.begin(), result.end());
     return result;
 }
-} // namespace
+
+linker::lookup_context::lookup_context(const std::vector<std::string>& scope) : has_scope_(true)
+{
+    prefix_ends_.push_back(0u);
+    for (auto& name : scope)
+    {
+        // same as process_link_name()
+        std::remove_copy(name.begin(), name.end(), std::back_inserter(prefix_), ' ');
+        prefix_ += "::";
+        prefix_ends_.push_back(prefix_.size());
+    }
+}
 
 type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
     lookup_documentation(type_safe::optional_ref<const cppast::cpp_entity> context,
                          std::string                                       link_name) const
 {
-    auto relative = is_relative(link_name);
-    link_name     = process_link_name(std::move(link_name));
+    if (context)
+        return lookup_documentation_impl(lookup_context(get_link_scope(context.value())),
+                                         std::move(link_name));
+    else
+        return lookup_documentation_impl(lookup_context(), std::move(link_name));
+}
+
+type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
+    lookup_documentation(const std::vector<std::string>& scope, std::string link_name) const
+{
+    return lookup_documentation_impl(lookup_context(scope), std::move(link_name));
+}
 
-    // performs local lookup
-    auto do_lookup = [&](const std::string& link_name)
-        -> type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> {
-        std::lock_guard<std::mutex> lock(mutex_);
-        auto                        iter = map_.find(process_link_name(link_name));
-        if (iter == map_.end())
-            return type_safe::nullvar;
+type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
+    lookup_documentation(lookup_context& context, std::string link_name) const
+{
+    if (!frozen_)
+        // result might change with further registrations
+        return lookup_documentation_impl(context, std::move(link_name));
+
+    auto iter = context.results_.find(link_name);
+    if (iter != context.results_.end())
         return iter->second;
-    };
+
+    auto result = lookup_documentation_impl(context, link_name);
+    context.results_.emplace(std::move(link_name), result);
+    return result;
+}
+
+type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> linker::
+    lookup_documentation_impl(const lookup_context& context, std::string link_name) const
+{
+    auto relative = is_relative(link_name);
+    link_name     = process_link_name(std::move(link_name));
 
     auto external_iter = external_doc_.lower_bound(link_name);
     if (external_iter != external_doc_.begin()
@@ -203,22 +294,25 @@ type_safe::variant<type_safe::nullvar_t, markup::block_reference, markup::url> l
         return get_url(external_iter->second, link_name);
     }
     else if (!relative)
+    {
         // absolute lookup
-        return do_lookup(link_name);
-    else
+        if (auto ref = find(link_name))
+            return ref.value();
+    }
+    else if (context.has_scope_)
     {
-        // relative lookup
-        while (context)
+        // relative lookup, from the innermost scope outwards
+        std::string name;
+        for (auto level = context.prefix_ends_.size(); level-- != 0u;)
         {
-            if (auto result = do_lookup(get_entity_scope(context.value()) + link_name))
-                return result;
-
-            // go to parent
-            context = context.value().parent();
+            name.assign(context.prefix_, 0u, context.prefix_ends_[level]);
+            name += link_name;
+            if (auto ref = find(name))
+                return ref.value();
         }
-
-        return type_safe::nullvar;
     }
+
+    return type_safe::nullvar;
 }
 
 namespace
@@ -362,17 +456,13 @@ cppast::source_location get_location(const markup::document_entity&    document,
 void standardese::resolve_links(const cppast::diagnostic_logger& logger, const linker& l,
                                 const markup::document_entity& document)
 {
-    auto get_context
-        = [](const markup::entity& entity) -> type_safe::optional_ref<const cppast::cpp_entity> {
-        if (entity.kind() == markup::entity_kind::file_documentation)
-            return type_safe::opt_ref(
-                &static_cast<const markup::file_documentation&>(entity).file());
-        else if (entity.kind() == markup::entity_kind::entity_documentation)
-            return type_safe::opt_ref(
-                &static_cast<const markup::entity_documentation&>(entity).entity());
-        else if (entity.kind() == markup::entity_kind::namespace_documentation)
-            return type_safe::opt_ref(
-                &static_cast<const markup::namespace_documentation&>(entity).namespace_());
+    auto get_context = [](const markup::entity& entity)
+        -> type_safe::optional_ref<const std::vector<std::string>> {
+        if (entity.kind() == markup::entity_kind::file_documentation
+            || entity.kind() == markup::entity_kind::entity_documentation
+            || entity.kind() == markup::entity_kind::namespace_documentation)
+            return type_safe::ref(
+                static_cast<const markup::documentation_entity&>(entity).link_scope());
         else
             return nullptr;
     };
@@ -386,14 +476,17 @@ void standardese::resolve_links(const cppast::diagnostic_logger& logger, const l
         return markup::block_id();
     };
 
-    type_safe::optional_ref<const cppast::cpp_entity> context;
+    // one context per distinct scope, so links from entities in the same scope share the results
+    linker::lookup_context                                  no_context;
+    std::unordered_map<std::string, linker::lookup_context> contexts;
+    auto                                                    context = &no_context;
     markup::visit(document, [&](const markup::entity& entity) {
         if (entity.kind() == markup::entity_kind::documentation_link)
         {
             auto& link = static_cast<const markup::documentation_link&>(entity);
             if (auto unresolved = link.unresolved_destination())
             {
-                auto destination = l.lookup_documentation(context, unresolved.value());
+                auto destination = l.lookup_documentation(*context, unresolved.value());
                 if (auto block = destination.optional_value(
                         type_safe::variant_type<markup::block_reference>{}))
                 {
@@ -401,7 +494,7 @@ void standardese::resolve_links(const cppast::diagnostic_logger& logger, const l
                                          || block.value().document().value().name()
                                                 == document.output_name().name();
                     if (!same_document
-                        || block.value().id().as_str() != get_documentation_block(entity).as_str())
+                        || block.value().id() != get_documentation_block(entity))
                         // only resolve if points to something different
                         link.resolve_destination(block.value());
                 }
@@ -414,7 +507,17 @@ void standardese::resolve_links(const cppast::diagnostic_logger& logger, const l
                                                "unresolved link name '", unresolved.value(), '\''));
             }
         }
-        else if (auto new_context = get_context(entity))
-            context = new_context;
+        else if (auto scope = get_context(entity))
+        {
+            std::string key;
+            for (auto& name : scope.value())
+                key.append(name).push_back('\n');
+
+            auto iter = contexts.find(key);
+            if (iter == contexts.end())
+                iter = contexts.emplace(std::move(key), linker::lookup_context(scope.value()))
+                           .first;
+            context = &iter->second;
+        }
     });
 }
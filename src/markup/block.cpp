@@ -4,6 +4,11 @@
 
 #include <standardese/markup/block.hpp>
 
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+
 using namespace standardese::markup;
 
 namespace
@@ -19,9 +24,14 @@ constexpr bool is_digit(char c)
     return c >= '0' && c <= '9';
 }
 
+bool needs_escape(char c)
+{
+    return !is_alpha(c) && !is_digit(c) && c != '_' && c != '-';
+}
+
 void escape_char(std::string& str, char c)
 {
-    if (is_alpha(c) || is_digit(c) || c == '_' || c == '-')
+    if (!needs_escape(c))
         str += c;
     // distinction is somewhat arbitrary
     else if (c == ':')
@@ -29,13 +39,69 @@ void escape_char(std::string& str, char c)
     else
         str += '-';
 }
+
+// returns an empty string if nothing needs escaping
+std::string escape(const std::string& str)
+{
+    std::string result;
+    if (std::any_of(str.begin(), str.end(), &needs_escape))
+    {
+        result.reserve(str.size());
+        for (auto c : str)
+            escape_char(result, c);
+    }
+    return result;
+}
+
+struct interned_hash
+{
+    std::size_t operator()(const detail::interned_string& str) const noexcept
+    {
+        return std::hash<std::string>{}(str.str);
+    }
+};
+
+struct interned_equal
+{
+    bool operator()(const detail::interned_string& a, const detail::interned_string& b) const
+        noexcept
+    {
+        return a.str == b.str;
+    }
+};
+
+// the table is split into shards, so threads interning different strings rarely block each other
+// the elements of an unordered_set are never moved, so references to them stay valid
+struct intern_shard
+{
+    std::mutex                                                                 mutex;
+    std::unordered_set<detail::interned_string, interned_hash, interned_equal> strings;
+};
+
+constexpr std::size_t no_shards = 32u;
+
+intern_shard* get_shards()
+{
+    // never destroyed, ids might be used during the destruction of other static objects
+    static auto shards = new intern_shard[no_shards];
+    return shards;
+}
 } // namespace
 
-std::string block_id::as_output_str() const
+const detail::interned_string& detail::intern(std::string str)
 {
-    std::string id;
-    id.reserve(id_.size());
-    for (auto c : id_)
-        escape_char(id, c);
-    return id;
+    static const interned_string empty{};
+    if (str.empty())
+        return empty;
+
+    interned_string key{std::move(str), {}};
+    auto&           shard = get_shards()[interned_hash{}(key) % no_shards];
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto                        iter = shard.strings.find(key);
+    if (iter != shard.strings.end())
+        return *iter;
+
+    key.escaped = escape(key.str);
+    return *shard.strings.insert(std::move(key)).first;
 }
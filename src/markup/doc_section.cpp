@@ -56,20 +56,28 @@ const char* get_suffix(section_type type) noexcept
     return "";
 }
 
-block_id get_section_id(type_safe::optional_ref<const entity> parent, section_type type)
+block_id get_parent_id(type_safe::optional_ref<const entity> parent)
 {
     if (!parent
         || (parent.value().kind() != entity_kind::entity_documentation
             && parent.value().kind() != entity_kind::file_documentation))
         return block_id();
-    auto entity_id = static_cast<const block_entity&>(parent.value()).id();
-    return block_id(entity_id.as_str() + '-' + get_suffix(type));
+    return static_cast<const block_entity&>(parent.value()).id();
 }
 } // namespace
 
 block_id brief_section::id() const
 {
-    return get_section_id(parent(), section_type::brief);
+    auto parent_id = get_parent_id(parent());
+    if (parent_id.empty())
+        return block_id();
+    else if (cached_parent_id_.load(std::memory_order_acquire) == parent_id)
+        return cached_id_.load(std::memory_order_relaxed);
+
+    block_id id(parent_id.as_str() + '-' + get_suffix(section_type::brief));
+    cached_id_.store(id, std::memory_order_relaxed);
+    cached_parent_id_.store(parent_id, std::memory_order_release);
+    return id;
 }
 
 entity_kind brief_section::do_get_kind() const noexcept
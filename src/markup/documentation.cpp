@@ -57,6 +57,7 @@ std::unique_ptr<entity> entity_documentation::do_clone() const
     builder b(entity_, id(),
               header() ? type_safe::make_optional(header().value().clone()) : type_safe::nullopt,
               synopsis() ? markup::clone(synopsis().value()) : nullptr);
+    b.set_link_scope(link_scope());
     for (auto& sec : doc_sections())
         b.add_section_impl(detail::unchecked_downcast<doc_section>(sec.clone()));
     for (auto& child : *this)
@@ -88,6 +89,7 @@ std::unique_ptr<entity> file_documentation::do_clone() const
     builder b(file_, id(),
               header() ? type_safe::make_optional(header().value().clone()) : type_safe::nullopt,
               synopsis() ? markup::clone(synopsis().value()) : nullptr);
+    b.set_link_scope(link_scope());
     for (auto& sec : doc_sections())
         b.add_section_impl(detail::unchecked_downcast<doc_section>(sec.clone()));
     for (auto& child : *this)
@@ -0,0 +1,134 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/entity_arena.hpp>
+
+#include <atomic>
+#include <new>
+
+#include <standardese/doc_entity.hpp>
+#include <standardese/markup/entity.hpp>
+
+using namespace standardese;
+
+struct markup::detail::arena_state
+{
+    // one for the entity_arena object and one for every entity allocated from it
+    std::atomic<std::size_t> references;
+    // only used by the thread of the entity_arena object
+    void* chunks;
+    char* chunk_begin;
+    char* chunk_end;
+};
+
+namespace
+{
+// every entity is prefixed by a header with the arena it belongs to, nullptr if none
+struct alignas(std::max_align_t) entity_header
+{
+    markup::detail::arena_state* arena;
+};
+
+constexpr std::size_t chunk_size = 64u * 1024u;
+// bigger entities use the global allocator
+constexpr std::size_t max_entity_size = chunk_size / 16u;
+
+thread_local markup::detail::arena_state* current_arena = nullptr;
+
+void free_chunks(markup::detail::arena_state* arena) noexcept
+{
+    // the first bytes of a chunk point to the previous one
+    while (arena->chunks)
+    {
+        auto prev = *static_cast<void**>(arena->chunks);
+        ::operator delete(arena->chunks);
+        arena->chunks = prev;
+    }
+    delete arena;
+}
+
+void release(markup::detail::arena_state* arena) noexcept
+{
+    if (arena->references.fetch_sub(1u, std::memory_order_acq_rel) == 1u)
+        free_chunks(arena);
+}
+
+void* allocate_entity(std::size_t size)
+{
+    auto arena = current_arena;
+    // round up, so the next entity is aligned as well
+    auto total = (sizeof(entity_header) + size + alignof(std::max_align_t) - 1u)
+                 / alignof(std::max_align_t) * alignof(std::max_align_t);
+
+    void* memory;
+    if (!arena || size > max_entity_size)
+    {
+        arena  = nullptr;
+        memory = ::operator new(total);
+    }
+    else
+    {
+        if (std::size_t(arena->chunk_end - arena->chunk_begin) < total)
+        {
+            // the rest of the previous chunk is too small and unused
+            auto chunk                  = ::operator new(chunk_size);
+            *static_cast<void**>(chunk) = arena->chunks;
+            arena->chunks               = chunk;
+            arena->chunk_begin = static_cast<char*>(chunk) + sizeof(entity_header);
+            arena->chunk_end   = static_cast<char*>(chunk) + chunk_size;
+        }
+
+        memory = arena->chunk_begin;
+        arena->chunk_begin += total;
+        arena->references.fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    auto header = ::new (memory) entity_header{arena};
+    return header + 1;
+}
+
+void deallocate_entity(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+
+    auto header = static_cast<entity_header*>(ptr) - 1;
+    if (auto arena = header->arena)
+        release(arena);
+    else
+        ::operator delete(header);
+}
+} // namespace
+
+markup::entity_arena::entity_arena()
+: state_(new detail::arena_state{{1u}, nullptr, nullptr, nullptr}), previous_(current_arena)
+{
+    current_arena = state_;
+}
+
+markup::entity_arena::~entity_arena() noexcept
+{
+    current_arena = previous_;
+    release(state_);
+}
+
+void* markup::entity::operator new(std::size_t size)
+{
+    return allocate_entity(size);
+}
+
+void markup::entity::operator delete(void* ptr) noexcept
+{
+    deallocate_entity(ptr);
+}
+
+void* doc_entity::operator new(std::size_t size)
+{
+    return allocate_entity(size);
+}
+
+void doc_entity::operator delete(void* ptr) noexcept
+{
+    deallocate_entity(ptr);
+}
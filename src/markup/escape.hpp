@@ -5,9 +5,17 @@
 #ifndef STANDARDESE_MARKUP_ESCAPE_HPP_INCLUDED
 #define STANDARDESE_MARKUP_ESCAPE_HPP_INCLUDED
 
-#include <cstdio>
 #include <cstring>
-#include <ostream>
+#include <exception>
+
+#include <standardese/markup/generator.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#    define STANDARDESE_DETAIL_SSE2 1
+#    include <emmintrin.h>
+#else
+#    define STANDARDESE_DETAIL_SSE2 0
+#endif
 
 namespace standardese
 {
@@ -15,59 +23,207 @@ namespace markup
 {
     namespace detail
     {
-        inline void write_html_text(std::ostream& out, const char* str)
+        // buffers the output, so it isn't written to the sink character by character
+        // the streams write closing tags in their destructors,
+        // so an exception of the sink is stored and only rethrown by flush(),
+        // the output after the error is discarded
+        class output_buffer
+        {
+        public:
+            explicit output_buffer(output_sink& out) noexcept : out_(&out), size_(0u) {}
+
+            output_buffer(const output_buffer&) = delete;
+            output_buffer& operator=(const output_buffer&) = delete;
+
+            // doesn't flush, the output must be flushed explicitly
+            ~output_buffer() noexcept = default;
+
+            void write(const char* str, std::size_t size) noexcept
+            {
+                if (size > sizeof(buffer_) - size_)
+                {
+                    write_buffer();
+                    if (size > sizeof(buffer_))
+                    {
+                        write_out(str, size);
+                        return;
+                    }
+                }
+
+                std::memcpy(buffer_ + size_, str, size);
+                size_ += size;
+            }
+
+            void write(const char* str) noexcept
+            {
+                write(str, std::strlen(str));
+            }
+
+            void put(char c) noexcept
+            {
+                if (size_ == sizeof(buffer_))
+                    write_buffer();
+                buffer_[size_++] = c;
+            }
+
+            // writes the buffered output to the sink
+            // and rethrows the exception of the sink, if there was one
+            void flush()
+            {
+                write_buffer();
+                if (error_)
+                    std::rethrow_exception(error_);
+            }
+
+        private:
+            void write_buffer() noexcept
+            {
+                write_out(buffer_, size_);
+                size_ = 0u;
+            }
+
+            void write_out(const char* str, std::size_t size) noexcept
+            {
+                if (error_)
+                    return;
+
+                try
+                {
+                    out_->write(str, size);
+                }
+                catch (...)
+                {
+                    error_ = std::current_exception();
+                }
+            }
+
+            output_sink*       out_;
+            std::exception_ptr error_;
+            char               buffer_[4096];
+            std::size_t        size_;
+        };
+
+        inline bool needs_html_escaping(char c) noexcept
+        {
+            return c == '&' || c == '<' || c == '>' || c == '"' || c == '\'' || c == '/';
+        }
+
+        // returns a pointer to the first character in [begin, end) that needs escaping, or end
+        inline const char* find_html_escape(const char* begin, const char* end) noexcept
+        {
+#if STANDARDESE_DETAIL_SSE2
+            // compare 16 characters at once against each special character
+            const auto amp   = _mm_set1_epi8('&');
+            const auto lt    = _mm_set1_epi8('<');
+            const auto gt    = _mm_set1_epi8('>');
+            const auto quot  = _mm_set1_epi8('"');
+            const auto apos  = _mm_set1_epi8('\'');
+            const auto slash = _mm_set1_epi8('/');
+            for (; end - begin >= 16; begin += 16)
+            {
+                auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                auto match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, amp),
+                                                       _mm_cmpeq_epi8(chars, lt)),
+                                          _mm_or_si128(_mm_cmpeq_epi8(chars, gt),
+                                                       _mm_cmpeq_epi8(chars, quot)));
+                match      = _mm_or_si128(match, _mm_or_si128(_mm_cmpeq_epi8(chars, apos),
+                                                         _mm_cmpeq_epi8(chars, slash)));
+
+                auto mask = unsigned(_mm_movemask_epi8(match));
+                if (mask != 0u)
+                {
+                    while ((mask & 1u) == 0u)
+                    {
+                        mask >>= 1;
+                        ++begin;
+                    }
+                    return begin;
+                }
+            }
+#endif
+            while (begin != end && !needs_html_escaping(*begin))
+                ++begin;
+            return begin;
+        }
+
+        inline void write_html_text(output_buffer& out, const char* str, std::size_t size)
         {
             // implements rule 1 here:
             // https://www.owasp.org/index.php/XSS_(Cross_Site_Scripting)_Prevention_Cheat_Sheet
-            for (auto ptr = str; *ptr; ++ptr)
+            auto end = str + size;
+            while (str != end)
             {
-                auto c = *ptr;
+                // copy everything up to the next special character at once
+                auto special = find_html_escape(str, end);
+                out.write(str, std::size_t(special - str));
+                if (special == end)
+                    break;
+
+                auto c = *special;
                 if (c == '&')
-                    out << "&amp;";
+                    out.write("&amp;", 5u);
                 else if (c == '<')
-                    out << "&lt;";
+                    out.write("&lt;", 4u);
                 else if (c == '>')
-                    out << "&gt;";
+                    out.write("&gt;", 4u);
                 else if (c == '"')
-                    out << "&quot;";
+                    out.write("&quot;", 6u);
                 else if (c == '\'')
-                    out << "&#x27;";
+                    out.write("&#x27;", 6u);
                 else if (c == '/')
-                    out << "&#x2F;";
-                else
-                    out << c;
+                    out.write("&#x2F;", 6u);
+                str = special + 1;
             }
         }
 
-        inline bool needs_url_escaping(char c)
+        inline void write_html_text(output_buffer& out, const char* str)
+        {
+            write_html_text(out, str, std::strlen(str));
+        }
+
+        inline bool needs_url_escaping(char c) noexcept
         {
             // don't escape reserved URL characters
             // don't escape safe URL characters
-            char safe[] = "-_.+!*(),%#@?=;:/,+$"
-                          "0123456789"
-                          "abcdefghijklmnopqrstuvwxyz"
-                          "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-            return std::strchr(safe, c) == nullptr;
+            struct table
+            {
+                bool escape[256];
+
+                table() noexcept
+                {
+                    const char safe[] = "-_.+!*(),%#@?=;:/,+$"
+                                        "0123456789"
+                                        "abcdefghijklmnopqrstuvwxyz"
+                                        "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+                    for (auto& e : escape)
+                        e = true;
+                    for (auto ptr = safe; *ptr; ++ptr)
+                        escape[static_cast<unsigned char>(*ptr)] = false;
+                }
+            };
+            static const table t;
+            return t.escape[static_cast<unsigned char>(c)];
         }
 
-        inline void write_html_url(std::ostream& out, const char* url)
+        inline void write_html_url(output_buffer& out, const char* url)
         {
+            static const char hex[] = "0123456789ABCDEF";
             for (auto ptr = url; *ptr; ++ptr)
             {
                 auto c = *ptr;
                 if (c == '&')
-                    out << "&amp;";
+                    out.write("&amp;", 5u);
                 else if (c == '\'')
-                    out << "&#x27";
+                    out.write("&#x27", 5u);
                 else if (needs_url_escaping(c))
                 {
-                    char buf[3];
-                    std::snprintf(buf, 3, "%02X", unsigned(c));
-                    out << "%";
-                    out << buf;
+                    auto byte = static_cast<unsigned char>(c);
+                    out.put('%');
+                    out.put(hex[byte >> 4]);
+                    out.put(hex[byte & 0xF]);
                 }
                 else
-                    out << c;
+                    out.put(c);
             }
         }
     } // namespace detail
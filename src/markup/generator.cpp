@@ -4,16 +4,191 @@
 
 #include <standardese/markup/generator.hpp>
 
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <stdexcept>
+
+#if defined(_WIN32)
+#    include <fcntl.h>
+#    include <io.h>
+#    include <sys/stat.h>
+#else
+#    include <fcntl.h>
+#    include <unistd.h>
+#endif
 
 #include <standardese/markup/document.hpp>
 
 using namespace standardese::markup;
 
+void stream_output::do_write(const char* str, std::size_t size)
+{
+    out_->write(str, std::streamsize(size));
+}
+
+namespace
+{
+constexpr std::size_t file_buffer_size = 64u * 1024u;
+
+int open_file(const std::string& path)
+{
+#if defined(_WIN32)
+    return ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                   _S_IREAD | _S_IWRITE);
+#else
+    return ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+#endif
+}
+
+bool write_file(int fd, const char* str, std::size_t size)
+{
+    while (size > 0u)
+    {
+#if defined(_WIN32)
+        auto result = ::_write(fd, str, unsigned(std::min<std::size_t>(size, 1u << 30)));
+#else
+        auto result = ::write(fd, str, size);
+#endif
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+
+        str += result;
+        size -= std::size_t(result);
+    }
+    return true;
+}
+
+bool close_file(int fd)
+{
+#if defined(_WIN32)
+    return ::_close(fd) == 0;
+#else
+    return ::close(fd) == 0;
+#endif
+}
+} // namespace
+
+file_output::file_output(std::string path)
+: path_(std::move(path)), buffer_(new char[file_buffer_size]), size_(0u), fd_(open_file(path_))
+{
+    if (fd_ < 0)
+        throw std::runtime_error("unable to open '" + path_ + "'");
+}
+
+file_output::~file_output() noexcept
+{
+    if (fd_ >= 0)
+    {
+        write_file(fd_, buffer_.get(), size_);
+        close_file(fd_);
+    }
+}
+
+void file_output::close()
+{
+    if (fd_ < 0)
+        return;
+
+    flush();
+    auto fd = fd_;
+    fd_     = -1;
+    if (!close_file(fd))
+        throw std::runtime_error("unable to write '" + path_ + "'");
+}
+
+void file_output::flush()
+{
+    auto size = size_;
+    size_     = 0u;
+    if (!write_file(fd_, buffer_.get(), size))
+        throw std::runtime_error("unable to write '" + path_ + "'");
+}
+
+void file_output::do_write(const char* str, std::size_t size)
+{
+    if (fd_ < 0)
+        throw std::logic_error("write to closed file '" + path_ + "'");
+    else if (size > file_buffer_size - size_)
+    {
+        flush();
+        if (size >= file_buffer_size)
+        {
+            // big enough to write it directly
+            if (!write_file(fd_, str, size))
+                throw std::runtime_error("unable to write '" + path_ + "'");
+            return;
+        }
+    }
+
+    std::memcpy(buffer_.get() + size_, str, size);
+    size_ += size;
+}
+
+namespace
+{
+// the stream passed to a generator that takes a std::ostream
+class sink_streambuf : public std::streambuf
+{
+public:
+    explicit sink_streambuf(output_sink& out) : out_(&out)
+    {
+        setp(buffer_, buffer_ + sizeof(buffer_));
+    }
+
+private:
+    int_type overflow(int_type c) override
+    {
+        sync();
+        if (!traits_type::eq_int_type(c, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    int sync() override
+    {
+        auto size = std::size_t(pptr() - pbase());
+        setp(buffer_, buffer_ + sizeof(buffer_));
+        out_->write(buffer_, size);
+        return 0;
+    }
+
+    output_sink* out_;
+    char         buffer_[4096];
+};
+} // namespace
+
+generator::function generator::from_stream_generator(
+    std::function<void(std::ostream&, const entity&)> f)
+{
+    return [f](output_sink& out, const entity& e) {
+        sink_streambuf buffer(out);
+        std::ostream   stream(&buffer);
+        // rethrow the exceptions of the sink instead of only setting the badbit
+        stream.exceptions(std::ios_base::badbit);
+        f(stream, e);
+        stream.flush();
+    };
+}
+
+void generator::operator()(std::ostream& out, const entity& e) const
+{
+    stream_output output(out);
+    f_(output, e);
+}
+
 std::string standardese::markup::render(generator gen, const entity& e)
 {
-    std::ostringstream stream;
-    gen(stream, e);
-    return stream.str();
+    string_output output;
+    gen(output, e);
+    return output.release();
 }
@@ -5,7 +5,6 @@
 #include <standardese/markup/generator.hpp>
 
 #include <cassert>
-#include <ostream>
 
 #include <type_safe/deferred_construction.hpp>
 #include <type_safe/flag.hpp>
@@ -33,18 +32,27 @@ using namespace standardese::markup;
 
 namespace
 {
+// the output state shared by all streams of a document
+struct html_output
+{
+    detail::output_buffer buffer;
+    std::string           prefix, ext;
+
+    html_output(output_sink& out, std::string prefix, std::string extension)
+    : buffer(out), prefix(std::move(prefix)), ext(std::move(extension))
+    {}
+};
+
 class html_stream
 {
 public:
-    explicit html_stream(type_safe::object_ref<std::ostream> out, std::string prefix,
-                         std::string extension)
-    : out_(out), prefix_(std::move(prefix)), ext_(std::move(extension)), top_level_(true),
-      closing_newl_(false)
+    explicit html_stream(type_safe::object_ref<html_output> out)
+    : out_(out), top_level_(true), closing_newl_(false)
     {}
 
     html_stream(html_stream&& other)
-    : closing_(std::move(other.closing_)), out_(other.out_), prefix_(std::move(other.prefix_)),
-      ext_(other.extension()), top_level_(other.top_level_), closing_newl_(other.closing_newl_)
+    : closing_(std::move(other.closing_)), out_(other.out_), top_level_(other.top_level_),
+      closing_newl_(other.closing_newl_)
     {
         other.closing_.clear();
         other.top_level_.reset();
@@ -60,7 +68,7 @@ public:
 
     const std::string& extension() const noexcept
     {
-        return ext_;
+        return out_->ext;
     }
 
     // opens a new tag
@@ -74,88 +82,91 @@ public:
     html_stream open_tag(bool open_newl, bool closing_newl, const char* tag, block_id id,
                          const char* classes = "")
     {
-        *out_ << "<" << tag;
+        out_->buffer.put('<');
+        out_->buffer.write(tag);
         if (!id.empty())
         {
-            *out_ << " id=\"standardese-";
-            write(id.as_output_str().c_str());
-            *out_ << '"';
+            out_->buffer.write(" id=\"standardese-");
+            write(id.as_output_str());
+            out_->buffer.put('"');
         }
         if (*classes)
         {
-            *out_ << " class=\"standardese-";
+            out_->buffer.write(" class=\"standardese-");
             write(classes);
-            *out_ << '"';
+            out_->buffer.put('"');
         }
-        *out_ << ">";
+        out_->buffer.put('>');
 
         if (open_newl)
-            *out_ << "\n";
+            out_->buffer.put('\n');
 
-        return html_stream(out_, prefix_, extension(), tag, closing_newl);
+        return html_stream(out_, tag, closing_newl);
     }
 
     html_stream open_link(const char* title, const char* url, bool prefix)
     {
-        *out_ << "<a href=\"";
+        out_->buffer.write("<a href=\"");
         if (prefix)
-            detail::write_html_url(*out_, prefix_.c_str());
-        detail::write_html_url(*out_, url);
-        *out_ << '"';
+            detail::write_html_url(out_->buffer, out_->prefix.c_str());
+        detail::write_html_url(out_->buffer, url);
+        out_->buffer.put('"');
         if (*title)
         {
-            *out_ << " title=\"";
+            out_->buffer.write(" title=\"");
             write(title);
-            *out_ << '"';
+            out_->buffer.put('"');
         }
-        *out_ << ">";
-        return html_stream(out_, prefix_, extension(), "a", false);
+        out_->buffer.put('>');
+        return html_stream(out_, "a", false);
     }
 
     // closes the current tag
     void close()
     {
         if (!closing_.empty())
-            *out_ << "</" << closing_ << ">";
+        {
+            out_->buffer.write("</", 2u);
+            out_->buffer.write(closing_.data(), closing_.size());
+            out_->buffer.put('>');
+        }
         closing_.clear();
         if (closing_newl_.try_reset())
-            *out_ << '\n';
+            out_->buffer.put('\n');
     }
 
     void write_newl()
     {
         if (!top_level_.try_reset())
-            *out_ << '\n';
+            out_->buffer.put('\n');
     }
 
     // writes HTML text, properly escaped
     void write(const char* str)
     {
-        detail::write_html_text(*out_, str);
+        detail::write_html_text(out_->buffer, str);
     }
 
     void write(const std::string& str)
     {
-        write(str.c_str());
+        detail::write_html_text(out_->buffer, str.data(), str.size());
     }
 
     // writes raw HTML code
     void write_html(const char* html)
     {
-        *out_ << html;
+        out_->buffer.write(html);
     }
 
 private:
-    explicit html_stream(type_safe::object_ref<std::ostream> out, std::string prefix,
-                         std::string extension, std::string closing, bool closing_newl)
-    : closing_(std::move(closing)), out_(out), prefix_(std::move(prefix)),
-      ext_(std::move(extension)), top_level_(false), closing_newl_(closing_newl)
+    explicit html_stream(type_safe::object_ref<html_output> out, std::string closing,
+                         bool closing_newl)
+    : closing_(std::move(closing)), out_(out), top_level_(false), closing_newl_(closing_newl)
     {}
 
-    std::string                         closing_;
-    type_safe::object_ref<std::ostream> out_;
-    std::string                         prefix_, ext_;
-    type_safe::flag                     top_level_, closing_newl_;
+    std::string                        closing_;
+    type_safe::object_ref<html_output> out_;
+    type_safe::flag                    top_level_, closing_newl_;
 };
 
 void write_entity(html_stream& s, const entity& e);
@@ -715,8 +726,13 @@ void write_entity(html_stream& s, const entity& e)
 generator standardese::markup::html_generator(const std::string& prefix,
                                               const std::string& extension) noexcept
 {
-    return [prefix, extension](std::ostream& out, const entity& e) {
-        html_stream s(type_safe::ref(out), prefix, extension);
-        write_entity(s, e);
+    return [prefix, extension](output_sink& out, const entity& e) {
+        html_output output(out, prefix, extension);
+        {
+            // the closing tags are written when it is destroyed
+            html_stream s(type_safe::ref(output));
+            write_entity(s, e);
+        }
+        output.buffer.flush();
     };
 }
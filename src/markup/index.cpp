@@ -69,6 +69,7 @@ std::unique_ptr<entity> namespace_documentation::do_clone() const
 {
     builder b(ns_, id(),
               header() ? type_safe::make_optional(header().value().clone()) : type_safe::nullopt);
+    b.set_link_scope(link_scope());
     for (auto& sec : doc_sections())
         b.add_section_impl(detail::unchecked_downcast<doc_section>(sec.clone()));
     for (auto& child : *this)
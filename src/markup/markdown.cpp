@@ -4,10 +4,13 @@
 
 #include <standardese/markup/generator.hpp>
 
+#include <algorithm>
 #include <cassert>
-#include <cmark-gfm.h>
-#include <ostream>
-#include <sstream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
 
 #include <standardese/markup/block.hpp>
 #include <standardese/markup/code_block.hpp>
@@ -31,72 +34,746 @@ using namespace standardese::markup;
 
 namespace
 {
+// the output is the same as the one of cmark's CommonMark and plaintext renderers
+// with CMARK_OPT_NOBREAKS and no line width,
+// the markup is written as if it were a tree of the corresponding cmark nodes
+// the escaping, list end and fence rules are the ones of cmark-gfm 0.29.0.gfm.0,
+// other versions might render differently:
+// the golden tests in test/markup/markdown.cpp compare with the cmark they're built against
+
+// the cmark node types written
+enum class node_type
+{
+    document,
+    block_quote,
+    list,
+    item,
+    code_block,
+    html_block,
+    paragraph,
+    heading,
+    thematic_break,
+};
+
+// how a string is escaped in CommonMark
+enum class escaping
+{
+    literal,
+    normal,
+    url,
+    title,
+};
+
 struct options
 {
     std::string prefix, extension;
     bool        use_html;
 };
 
-void build_entity(cmark_node* parent, const options& opt, const entity& e);
+// the character classes of cmark, they only consider ASCII
+bool is_space(unsigned char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\f' || c == '\r';
+}
+
+bool is_digit(unsigned char c) noexcept
+{
+    return c >= '0' && c <= '9';
+}
+
+bool is_alpha(unsigned char c) noexcept
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool is_punct(unsigned char c) noexcept
+{
+    return (c >= '!' && c <= '/') || (c >= ':' && c <= '@') || (c >= '[' && c <= '`')
+           || (c >= '{' && c <= '~');
+}
+
+// decodes the UTF-8 code point at the beginning of str,
+// returns its length or 0 if it is invalid
+std::size_t decode_utf8(const char* str, std::size_t size, std::int32_t& c) noexcept
+{
+    auto bytes = reinterpret_cast<const unsigned char*>(str);
+
+    std::size_t length;
+    if (bytes[0] < 0x80u)
+        length = 1u;
+    else if (bytes[0] < 0xC0u)
+        return 0u;
+    else if (bytes[0] < 0xE0u)
+        length = 2u;
+    else if (bytes[0] < 0xF0u)
+        length = 3u;
+    else if (bytes[0] < 0xF8u)
+        length = 4u;
+    else
+        return 0u;
+
+    if (length > size)
+        return 0u;
+    for (auto i = 1u; i != length; ++i)
+        if ((bytes[i] & 0xC0u) != 0x80u)
+            return 0u;
+
+    switch (length)
+    {
+    case 1u:
+        c = bytes[0];
+        return 1u;
+    case 2u:
+        c = std::int32_t(((bytes[0] & 0x1Fu) << 6) | (bytes[1] & 0x3Fu));
+        return c < 0x80 ? 0u : 2u;
+    case 3u:
+        c = std::int32_t(((bytes[0] & 0x0Fu) << 12) | ((bytes[1] & 0x3Fu) << 6)
+                         | (bytes[2] & 0x3Fu));
+        return c < 0x800 || (c >= 0xD800 && c < 0xE000) ? 0u : 3u;
+    default:
+        c = std::int32_t(((bytes[0] & 0x07u) << 18) | ((bytes[1] & 0x3Fu) << 12)
+                         | ((bytes[2] & 0x3Fu) << 6) | (bytes[3] & 0x3Fu));
+        return c < 0x10000 || c >= 0x110000 ? 0u : 4u;
+    }
+}
+
+// writes the nodes directly to the output,
+// the blank lines between blocks and the prefixes of block quotes and list items
+// are written lazily before the next output, like cmark's renderer does
+class markdown_writer
+{
+public:
+    markdown_writer(output_sink& out, const options& opt, bool commonmark)
+    : buffer_(out),
+      opt_(&opt),
+      need_cr_(0u),
+      trailing_newlines_(0u),
+      last_('\0'),
+      only_newlines_(true),
+      begin_line_(true),
+      begin_content_(true),
+      in_tight_list_item_(false),
+      pending_list_end_(false),
+      commonmark_(commonmark)
+    {}
+
+    markdown_writer(const markdown_writer&) = delete;
+    markdown_writer& operator=(const markdown_writer&) = delete;
+
+    const options& opt() const noexcept
+    {
+        return *opt_;
+    }
+
+    bool is_commonmark() const noexcept
+    {
+        return commonmark_;
+    }
+
+    //=== blocks ===//
+    void enter_block(node_type type)
+    {
+        enter(type, false, false);
+
+        switch (type)
+        {
+        case node_type::block_quote:
+            if (commonmark_)
+            {
+                lit("> ");
+                begin_content_ = true;
+                prefix_ += "> ";
+            }
+            break;
+
+        case node_type::item:
+            lit(blocks_.back().marker.c_str());
+            begin_content_ = true;
+            prefix_.append(blocks_.back().marker.size(), ' ');
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void enter_list(bool ordered, bool tight)
+    {
+        enter(node_type::list, ordered, tight);
+    }
+
+    void enter_heading(unsigned level)
+    {
+        enter(node_type::heading, false, false);
+        if (commonmark_)
+        {
+            std::string marker(level, '#');
+            marker += ' ';
+            lit(marker.c_str());
+        }
+        begin_content_ = true;
+    }
+
+    void exit_block()
+    {
+        // a block that exits has no next sibling
+        pending_list_end_ = false;
+        update_tight_list_item();
+
+        auto& block = blocks_.back();
+        switch (block.type)
+        {
+        case node_type::block_quote:
+            if (commonmark_)
+            {
+                prefix_.resize(prefix_.size() - 2u);
+                blankline();
+            }
+            break;
+
+        case node_type::item:
+            prefix_.resize(prefix_.size() - block.marker.size());
+            cr();
+            break;
+
+        case node_type::heading:
+        case node_type::paragraph:
+            blankline();
+            break;
+
+        default:
+            break;
+        }
+
+        auto is_list = block.type == node_type::list;
+        blocks_.pop_back();
+        // whether the list has to be ended depends on the next sibling
+        pending_list_end_ = is_list;
+    }
+
+    void code_block(const char* info, const std::string& code)
+    {
+        auto first_in_list_item = enter(node_type::code_block, false, false);
+
+        if (!first_in_list_item)
+            blankline();
+        if (!commonmark_)
+            out(code.c_str(), escaping::literal);
+        else if (*info == '\0' && code.size() > 2u && !is_space(code.front())
+                 && !(is_space(code[code.size() - 1u]) && is_space(code[code.size() - 2u]))
+                 && !first_in_list_item)
+        {
+            // indented code block
+            lit("    ");
+            prefix_ += "    ";
+            out(code.c_str(), escaping::literal);
+            prefix_.resize(prefix_.size() - 4u);
+        }
+        else
+        {
+            // the fence has to be longer than any sequence of backticks in the code
+            std::size_t longest = 0u, cur = 0u;
+            for (auto c : code)
+                if (c == '`')
+                    longest = std::max(longest, ++cur);
+                else
+                    cur = 0u;
+            std::string fence(std::max(longest + 1u, std::size_t(3u)),
+                              std::strchr(info, '`') ? '~' : '`');
+
+            lit(fence.c_str());
+            lit(" ");
+            out(info, escaping::literal);
+            cr();
+            out(code.c_str(), escaping::literal);
+            cr();
+            lit(fence.c_str());
+        }
+        blankline();
+
+        blocks_.pop_back();
+    }
+
+    void html_block(const char* html)
+    {
+        enter(node_type::html_block, false, false);
+        if (commonmark_)
+        {
+            blankline();
+            lit(html);
+            blankline();
+        }
+        blocks_.pop_back();
+    }
+
+    void thematic_break()
+    {
+        enter(node_type::thematic_break, false, false);
+        blankline();
+        if (commonmark_)
+        {
+            lit("-----");
+            blankline();
+        }
+        blocks_.pop_back();
+    }
+
+    //=== inlines ===//
+    void text(const char* str)
+    {
+        out(str, escaping::normal);
+    }
+
+    void soft_break()
+    {
+        lit(" ");
+    }
+
+    void hard_break()
+    {
+        if (commonmark_)
+            lit("  ");
+        cr();
+    }
+
+    void code(const std::string& code)
+    {
+        if (!commonmark_)
+        {
+            out(code.c_str(), escaping::literal);
+            return;
+        }
+
+        // use the shortest sequence of backticks that doesn't occur in the code
+        std::uint32_t used = 1u;
+        std::size_t   cur  = 0u;
+        for (auto c : code)
+            if (c == '`')
+                ++cur;
+            else
+            {
+                if (cur > 0u && cur < 32u)
+                    used |= std::uint32_t(1u) << cur;
+                cur = 0u;
+            }
+        if (cur > 0u && cur < 32u)
+            used |= std::uint32_t(1u) << cur;
+
+        std::size_t ticks = 0u;
+        for (; ticks < 32u && (used & 1u); used >>= 1)
+            ++ticks;
+        std::string delimiter(ticks, '`');
+
+        auto extra_spaces = code.empty() || code.front() == '`' || code.back() == '`'
+                            || code.front() == ' ' || code.back() == ' ';
+
+        lit(delimiter.c_str());
+        if (extra_spaces)
+            lit(" ");
+        out(code.c_str(), escaping::literal);
+        if (extra_spaces)
+            lit(" ");
+        lit(delimiter.c_str());
+    }
+
+    void html_inline(const char* html)
+    {
+        if (commonmark_)
+            lit(html);
+    }
+
+    // writes the string without escaping
+    void lit(const char* str)
+    {
+        out(str, escaping::literal);
+    }
+
+    void out(const char* str, escaping esc)
+    {
+        if (in_tight_list_item_ && need_cr_ > 1u)
+            need_cr_ = 1u;
+        if (need_cr_ > 0u)
+        {
+            // newlines at the end of the output count for the line breaks that are needed
+            auto existing = only_newlines_ ? need_cr_ : std::min(need_cr_, trailing_newlines_);
+            for (auto n = need_cr_ - existing; n > 0u; --n)
+            {
+                put('\n');
+                if (n > 1u)
+                    write(prefix_.data(), prefix_.size());
+            }
+
+            need_cr_       = 0u;
+            begin_line_    = true;
+            begin_content_ = true;
+        }
+
+        auto size = std::strlen(str);
+        for (std::size_t i = 0u; i != size;)
+        {
+            if (begin_line_)
+                write(prefix_.data(), prefix_.size());
+
+            std::int32_t c;
+            auto         length = decode_utf8(str + i, size - i, c);
+            if (length == 0u)
+                // cmark ignores the rest of the string
+                return;
+
+            if (esc == escaping::literal && c == '\n')
+            {
+                put('\n');
+                begin_line_    = true;
+                begin_content_ = true;
+            }
+            else
+            {
+                if (esc == escaping::literal || !commonmark_)
+                    write_code_point(str + i, length, c);
+                else
+                    write_escaped(str + i, length, c, static_cast<unsigned char>(str[i + length]),
+                                  esc);
+
+                begin_line_ = false;
+                // the content only begins after a list number,
+                // cmark only looks at the lowest byte of the code point
+                begin_content_ = begin_content_ && is_digit(static_cast<unsigned char>(c));
+            }
+
+            i += length;
+        }
+    }
+
+    //=== finish ===//
+    void finish()
+    {
+        if (trailing_newlines_ == 0u)
+            put('\n');
+        buffer_.flush();
+    }
+
+private:
+    struct block
+    {
+        node_type   type;
+        bool        ordered, tight;
+        unsigned    children;
+        std::string marker;
+    };
+
+    // enters a block as the next child of the current one,
+    // returns whether it is the first child of a list item
+    bool enter(node_type type, bool ordered, bool tight)
+    {
+        auto first = true, in_list_item = false;
+        if (!blocks_.empty())
+        {
+            auto& parent = blocks_.back();
+            if (pending_list_end_)
+            {
+                pending_list_end_ = false;
+                if (type == node_type::code_block || type == node_type::list)
+                    end_list();
+            }
+
+            first        = parent.children++ == 0u;
+            in_list_item = parent.type == node_type::item;
+        }
+
+        std::string marker;
+        if (type == node_type::item)
+        {
+            if (!blocks_.back().ordered)
+                marker = "  - ";
+            else
+            {
+                // ordered lists start at 1
+                // the marker is at least four characters, like the one of bullet lists
+                auto number = blocks_.back().children;
+                marker      = std::to_string(number) + (number < 10u ? ".  " : ". ");
+            }
+        }
+
+        blocks_.push_back({type, ordered, tight, 0u, std::move(marker)});
+        // the first item doesn't change it,
+        // so a list that follows a paragraph is separated by a blank line
+        if (type != node_type::item || !first)
+            update_tight_list_item();
+
+        return first && in_list_item;
+    }
+
+    void end_list()
+    {
+        // ensures that a following code block or list isn't part of the list
+        cr();
+        if (commonmark_)
+        {
+            lit("<!-- end list -->");
+            blankline();
+        }
+    }
+
+    bool is_tight_item(std::size_t i) const noexcept
+    {
+        return i > 0u && blocks_[i].type == node_type::item && blocks_[i - 1u].tight;
+    }
+
+    // the line breaks between the children of a tight list item are never blank lines
+    void update_tight_list_item()
+    {
+        auto i              = blocks_.size() - 1u;
+        in_tight_list_item_ = is_tight_item(i) || (i > 0u && is_tight_item(i - 1u));
+    }
+
+    void cr() noexcept
+    {
+        need_cr_ = std::max(need_cr_, 1u);
+    }
+
+    void blankline() noexcept
+    {
+        need_cr_ = std::max(need_cr_, 2u);
+    }
+
+    void write_code_point(const char* str, std::size_t length, std::int32_t c)
+    {
+        // cmark's encoder writes these as a single byte
+        if (c == 0xFFFE || c == 0xFFFF)
+            put(char(c & 0xFF));
+        else
+            write(str, length);
+    }
+
+    void write_escaped(const char* str, std::size_t length, std::int32_t c, unsigned char next,
+                       escaping esc)
+    {
+        auto needs_escaping = false;
+        if (c < 0x80)
+        {
+            auto follows_digit = is_digit(static_cast<unsigned char>(last_));
+            if (esc == escaping::normal)
+                needs_escaping = std::strchr("*_[]#<>\\`!", int(c))
+                                 || (c == '&' && is_alpha(next))
+                                 || (begin_content_ && (c == '-' || c == '+' || c == '=')
+                                     && !follows_digit)
+                                 || (begin_content_ && (c == '.' || c == ')') && follows_digit
+                                     && (next == '\0' || is_space(next)));
+            else if (esc == escaping::url)
+                needs_escaping = std::strchr("`<>\\()", int(c)) || is_space(char(c));
+            else if (esc == escaping::title)
+                needs_escaping = std::strchr("`<>\"\\", int(c)) != nullptr;
+        }
+
+        if (!needs_escaping)
+            write_code_point(str, length, c);
+        else if (esc == escaping::url && is_space(char(c)))
+        {
+            // same format as cmark, including its padding with a space
+            char encoded[8];
+            std::snprintf(encoded, sizeof(encoded), "%%%2X", unsigned(c));
+            write(encoded, std::strlen(encoded));
+        }
+        else if (is_punct(char(c)))
+        {
+            put('\\');
+            put(char(c));
+        }
+        else
+        {
+            char encoded[16];
+            std::snprintf(encoded, sizeof(encoded), "&#%d;", int(c));
+            write(encoded, std::strlen(encoded));
+        }
+    }
+
+    void put(char c)
+    {
+        buffer_.put(c);
+        last_ = c;
+        if (c == '\n')
+            ++trailing_newlines_;
+        else
+        {
+            trailing_newlines_ = 0u;
+            only_newlines_     = false;
+        }
+    }
+
+    void write(const char* str, std::size_t size)
+    {
+        if (size == 0u)
+            return;
+
+        buffer_.write(str, size);
+        last_ = str[size - 1u];
+
+        auto newlines = std::size_t(0u);
+        while (newlines != size && str[size - newlines - 1u] == '\n')
+            ++newlines;
+        if (newlines == size)
+            trailing_newlines_ += unsigned(newlines);
+        else
+        {
+            trailing_newlines_ = unsigned(newlines);
+            only_newlines_     = false;
+        }
+    }
+
+    detail::output_buffer buffer_;
+    const options*        opt_;
+    std::vector<block>    blocks_;
+    std::string           prefix_;
+    unsigned              need_cr_, trailing_newlines_;
+    char                  last_;
+    bool                  only_newlines_, begin_line_, begin_content_, in_tight_list_item_,
+        pending_list_end_, commonmark_;
+};
+
+void write_entity(markdown_writer& w, const entity& e);
 
 template <typename T>
-void handle_children(cmark_node* node, const options& opt, const T& container)
+void write_children(markdown_writer& w, const T& container)
 {
     for (auto& child : container)
-        build_entity(node, opt, child);
+        write_entity(w, child);
 }
 
-cmark_node* build_emph(const char* str)
+bool has_destination(const documentation_link& link)
 {
-    auto emph = cmark_node_new(CMARK_NODE_EMPH);
-    auto text = cmark_node_new(CMARK_NODE_TEXT);
-    cmark_node_set_literal(text, str);
-    cmark_node_append_child(emph, text);
-    return emph;
+    return link.internal_destination() || link.external_destination();
 }
 
-cmark_node* build_heading(unsigned level, const char* str)
+// the text of a code block entity or text, nullptr otherwise
+const std::string* get_text(const entity& e)
 {
-    auto heading = cmark_node_new(CMARK_NODE_HEADING);
-    cmark_node_set_heading_level(heading, int(level));
-
-    if (str)
+    switch (e.kind())
     {
-        auto text = cmark_node_new(CMARK_NODE_TEXT);
-        cmark_node_set_literal(text, str);
-        cmark_node_append_child(heading, text);
+#define STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(Kind)                                                 \
+    case entity_kind::code_block_##Kind:                                                           \
+        return &static_cast<const code_block::Kind&>(e).string();
+
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(keyword)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(identifier)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(string_literal)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(int_literal)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(float_literal)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(punctuation)
+        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(preprocessor)
+
+#undef STANDARDESE_DETAIL_HANDLE_CODE_BLOCK
+
+    case entity_kind::text:
+        return &static_cast<const text&>(e).string();
+
+    default:
+        return nullptr;
     }
+}
+
+// appends the content of a code block,
+// links only write their content and everything but text and line breaks is ignored
+template <typename T>
+void append_code_block_text(std::string& result, const T& container)
+{
+    for (auto& child : container)
+        if (auto str = get_text(child))
+            // cmark stores C strings
+            result += str->c_str();
+        else if (child.kind() == entity_kind::soft_break
+                 || child.kind() == entity_kind::hard_break)
+            result += '\n';
+        else if (child.kind() == entity_kind::external_link)
+            append_code_block_text(result, static_cast<const external_link&>(child));
+        else if (child.kind() == entity_kind::documentation_link)
+            append_code_block_text(result, static_cast<const documentation_link&>(child));
+}
 
-    return heading;
+// appends the content of code, everything but text is ignored
+template <typename T>
+void append_code_text(std::string& result, const T& container)
+{
+    for (auto& child : container)
+        if (auto str = get_text(child))
+            result += str->c_str();
+        else if (child.kind() == entity_kind::documentation_link
+                 && !has_destination(static_cast<const documentation_link&>(child)))
+            append_code_text(result, static_cast<const documentation_link&>(child));
 }
 
-void build(cmark_node* parent, const options& opt, const code_block& cb);
+// calls f for every inline node in the container:
+// the content of a documentation link without destination is written in place of the link,
+// and code block entities are only written inside of code blocks
+template <typename T, typename Func>
+void for_each_inline(const T& container, Func&& f)
+{
+    for (auto& child : container)
+        if (child.kind() == entity_kind::documentation_link
+            && !has_destination(static_cast<const documentation_link&>(child)))
+            for_each_inline(static_cast<const documentation_link&>(child), f);
+        else if (child.kind() == entity_kind::text || !get_text(child))
+            f(child);
+}
 
-void build_list_item(cmark_node* list, const options& opt, const list_item_base& item);
+void write_inline(markdown_writer& w, const entity& e, bool nested_emphasis);
 
-void build_documentation(cmark_node* parent, const options& opt, const documentation_entity& doc)
+template <typename T>
+void write_inline_children(markdown_writer& w, const T& container, bool in_emphasis = false)
 {
-    if (opt.use_html)
+    // emphasis that is the only child of emphasis uses underscores,
+    // so it doesn't become strong emphasis
+    const entity* nested_emphasis = nullptr;
+    if (in_emphasis)
     {
-        auto html = cmark_node_new(CMARK_NODE_HTML_BLOCK);
+        auto count = 0u;
+        for_each_inline(container, [&](const entity& child) {
+            if (count++ == 0u && child.kind() == entity_kind::emphasis)
+                nested_emphasis = &child;
+        });
+        if (count != 1u)
+            nested_emphasis = nullptr;
+    }
 
-        std::ostringstream stream;
-        stream << "<span id=\"standardese-";
-        detail::write_html_text(stream, doc.id().as_output_str().c_str());
-        stream << "\"></span>\n";
+    for_each_inline(container, [&](const entity& child) {
+        write_inline(w, child, &child == nested_emphasis);
+    });
+}
+
+void write_heading(markdown_writer& w, unsigned level, const char* str)
+{
+    w.enter_heading(level);
+    w.text(str);
+    w.exit_block();
+}
+
+void write(markdown_writer& w, const code_block& cb);
+
+void write_list_item(markdown_writer& w, const list_item_base& item);
+
+void write_documentation(markdown_writer& w, const documentation_entity& doc)
+{
+    if (w.opt().use_html)
+    {
+        string_output output;
+        {
+            detail::output_buffer buffer(output);
+            buffer.write("<span id=\"standardese-");
+            detail::write_html_text(buffer, doc.id().as_output_str().c_str());
+            buffer.write("\"></span>\n");
+            buffer.flush();
+        }
 
-        cmark_node_set_literal(html, stream.str().c_str());
-        cmark_node_append_child(parent, html);
+        w.html_block(output.str().c_str());
     }
 
     if (doc.synopsis())
-        build(parent, opt, doc.synopsis().value());
+        write(w, doc.synopsis().value());
 
     if (auto brief = doc.brief_section())
     {
-        auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-        handle_children(paragraph, opt, brief.value());
-        cmark_node_append_child(parent, paragraph);
+        w.enter_block(node_type::paragraph);
+        write_inline_children(w, brief.value());
+        w.exit_block();
     }
 
     // write inline sections
@@ -108,24 +785,26 @@ void build_documentation(cmark_node* parent, const options& opt, const documenta
             {
                 auto& sec = static_cast<const inline_section&>(section);
 
-                auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-                cmark_node_append_child(parent, paragraph);
+                w.enter_block(node_type::paragraph);
 
-                // add section name
-                auto emph = build_emph((sec.name() + ":").c_str());
-                cmark_node_append_child(paragraph, emph);
-                auto sep = cmark_node_new(CMARK_NODE_TEXT);
-                cmark_node_set_literal(sep, " ");
-                cmark_node_append_child(paragraph, sep);
+                // write section name
+                if (w.is_commonmark())
+                    w.lit("*");
+                w.text((sec.name() + ":").c_str());
+                if (w.is_commonmark())
+                    w.lit("*");
+                w.text(" ");
 
-                // build section content
-                handle_children(paragraph, opt, sec);
+                // write section content
+                write_inline_children(w, sec);
+
+                w.exit_block();
             }
     }
 
     // write details section
     if (auto details = doc.details_section())
-        handle_children(parent, opt, details.value());
+        write_children(w, details.value());
 
     // write list sections
     for (auto& section : doc.doc_sections())
@@ -135,52 +814,37 @@ void build_documentation(cmark_node* parent, const options& opt, const documenta
         {
             auto& list = static_cast<const list_section&>(section);
 
-            // heading
-            auto heading = build_heading(4, list.name().c_str());
-            cmark_node_append_child(parent, heading);
-
-            // list
-            auto ul = cmark_node_new(CMARK_NODE_LIST);
-            cmark_node_set_list_type(ul, CMARK_BULLET_LIST);
-            cmark_node_set_list_tight(ul, 1);
-            cmark_node_append_child(parent, ul);
+            write_heading(w, 4, list.name().c_str());
 
+            w.enter_list(false, true);
             for (auto& item : list)
-                build_list_item(ul, opt, item);
+                write_list_item(w, item);
+            w.exit_block();
         }
 }
 
-void append_module(cmark_node* heading, const std::string& module)
-{
-    auto text = cmark_node_new(CMARK_NODE_TEXT);
-    cmark_node_set_literal(text, (" [" + module + "]").c_str());
-    cmark_node_append_child(heading, text);
-}
-
-void build_doc_header(cmark_node* parent, const options& opt, const documentation_header& header,
-                      unsigned level)
+void write_doc_header(markdown_writer& w, const documentation_header& header, unsigned level)
 {
-    auto heading = build_heading(level, nullptr);
-    cmark_node_append_child(parent, heading);
-
-    handle_children(heading, opt, header.heading());
+    w.enter_heading(level);
 
+    write_inline_children(w, header.heading());
     if (header.module())
-        append_module(heading, header.module().value());
+        w.text((" [" + header.module().value() + "]").c_str());
+
+    w.exit_block();
 }
 
-void build_doc_header(cmark_node* parent, const options& opt, const documentation_entity& doc,
-                      unsigned level)
+void write_doc_header(markdown_writer& w, const documentation_entity& doc, unsigned level)
 {
     if (doc.header())
-        build_doc_header(parent, opt, doc.header().value(), level);
+        write_doc_header(w, doc.header().value(), level);
 }
 
-void build(cmark_node* parent, const options& opt, const file_documentation& doc)
+void write(markdown_writer& w, const file_documentation& doc)
 {
-    build_doc_header(parent, opt, doc, 1);
-    build_documentation(parent, opt, doc);
-    handle_children(parent, opt, doc);
+    write_doc_header(w, doc, 1);
+    write_documentation(w, doc);
+    write_children(w, doc);
 }
 
 unsigned get_documentation_heading_level(const documentation_entity& doc)
@@ -194,399 +858,384 @@ unsigned get_documentation_heading_level(const documentation_entity& doc)
     return 2;
 }
 
-void build(cmark_node* parent, const options& opt, const entity_documentation& doc)
+void write(markdown_writer& w, const entity_documentation& doc)
 {
-    build_doc_header(parent, opt, doc, get_documentation_heading_level(doc));
-    build_documentation(parent, opt, doc);
-    handle_children(parent, opt, doc);
+    write_doc_header(w, doc, get_documentation_heading_level(doc));
+    write_documentation(w, doc);
+    write_children(w, doc);
 
     if (doc.header())
-        cmark_node_append_child(parent, cmark_node_new(CMARK_NODE_THEMATIC_BREAK));
+        w.thematic_break();
 }
 
-void build(cmark_node* parent, const options& opt, const entity_index_item& item);
-void build(cmark_node* parent, const options& opt, const namespace_documentation& doc);
-void build(cmark_node* parent, const options& opt, const module_documentation& doc);
+void write(markdown_writer& w, const entity_index_item& item);
+
+template <class T>
+void write_module_ns(markdown_writer& w, const T& doc);
 
-void build_index_child(cmark_node* parent, const options& opt, const block_entity& child)
+void write_index_child(markdown_writer& w, const block_entity& child)
 {
     if (child.kind() == entity_kind::entity_index_item)
-        build(parent, opt, static_cast<const entity_index_item&>(child));
+        write(w, static_cast<const entity_index_item&>(child));
     else if (child.kind() == entity_kind::namespace_documentation)
-        build(parent, opt, static_cast<const namespace_documentation&>(child));
+        write_module_ns(w, static_cast<const namespace_documentation&>(child));
     else if (child.kind() == entity_kind::module_documentation)
-        build(parent, opt, static_cast<const module_documentation&>(child));
+        write_module_ns(w, static_cast<const module_documentation&>(child));
     else
         assert(false);
 }
 
 template <class T>
-void build_module_ns(cmark_node* parent, const options& opt, const T& doc)
+void write_module_ns(markdown_writer& w, const T& doc)
 {
-    auto item = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, item);
+    w.enter_block(node_type::item);
 
-    build_doc_header(item, opt, doc, get_documentation_heading_level(doc));
-    build_documentation(item, opt, doc);
-
-    auto list = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(list, CMARK_BULLET_LIST);
-    cmark_node_append_child(item, list);
+    write_doc_header(w, doc, get_documentation_heading_level(doc));
+    write_documentation(w, doc);
 
+    w.enter_list(false, false);
     for (auto& child : doc)
-        build_index_child(list, opt, child);
-}
+        write_index_child(w, child);
+    w.exit_block();
 
-void build(cmark_node* parent, const options& opt, const namespace_documentation& doc)
-{
-    build_module_ns(parent, opt, doc);
+    w.exit_block();
 }
 
-void build(cmark_node* parent, const options& opt, const module_documentation& doc)
+void write(markdown_writer&, const module_documentation&)
 {
-    build_module_ns(parent, opt, doc);
+    // it is a list item outside of a list, which cmark didn't write
 }
 
-void build_term_description(cmark_node* parent, const options& opt, const term& t,
-                            const description* desc);
+void write_term_description(markdown_writer& w, const term& t, const description* desc);
 
-void build(cmark_node* parent, const options& opt, const entity_index_item& item)
+void write(markdown_writer& w, const entity_index_item& item)
 {
-    auto node = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, node);
-    build_term_description(node, opt, item.entity(),
-                           item.brief() ? &item.brief().value() : nullptr);
+    w.enter_block(node_type::item);
+    write_term_description(w, item.entity(), item.brief() ? &item.brief().value() : nullptr);
+    w.exit_block();
 }
 
 template <class Index>
-void build_index(cmark_node* parent, const options& opt, const Index& index)
+void write_index(markdown_writer& w, const Index& index)
 {
-    auto heading = build_heading(1, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, index.heading());
-
-    auto list = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(list, CMARK_BULLET_LIST);
-    cmark_node_append_child(parent, list);
+    w.enter_heading(1);
+    write_inline_children(w, index.heading());
+    w.exit_block();
 
+    w.enter_list(false, false);
     for (auto& child : index)
-        build_index_child(list, opt, child);
+        write_index_child(w, child);
+    w.exit_block();
 }
 
-void build(cmark_node* parent, const options& opt, const file_index& index)
+void write(markdown_writer& w, const file_index& index)
 {
-    build_index(parent, opt, index);
+    write_index(w, index);
 }
 
-void build(cmark_node* parent, const options& opt, const entity_index& index)
+void write(markdown_writer& w, const entity_index& index)
 {
-    build_index(parent, opt, index);
+    write_index(w, index);
 }
 
-void build(cmark_node* parent, const options& opt, const module_index& index)
+void write(markdown_writer& w, const module_index& index)
 {
-    build_index(parent, opt, index);
+    write_index(w, index);
 }
 
-void build(cmark_node* parent, const options& opt, const heading& h)
+void write(markdown_writer& w, const heading& h)
 {
-    auto heading = build_heading(4, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, h);
+    w.enter_heading(4);
+    write_inline_children(w, h);
+    w.exit_block();
 }
 
-void build(cmark_node* parent, const options& opt, const subheading& h)
+void write(markdown_writer& w, const subheading& h)
 {
-    auto heading = build_heading(5, nullptr);
-    cmark_node_append_child(parent, heading);
-    handle_children(heading, opt, h);
+    w.enter_heading(5);
+    write_inline_children(w, h);
+    w.exit_block();
 }
 
-void build(cmark_node* parent, const options& opt, const paragraph& par)
+void write(markdown_writer& w, const paragraph& par)
 {
-    auto node = cmark_node_new(CMARK_NODE_PARAGRAPH);
-    cmark_node_append_child(parent, node);
-    handle_children(node, opt, par);
+    w.enter_block(node_type::paragraph);
+    write_inline_children(w, par);
+    w.exit_block();
 }
 
-void build_term_description(cmark_node* parent, const options& opt, const term& t,
-                            const description* desc)
+void write_term_description(markdown_writer& w, const term& t, const description* desc)
 {
-    auto paragraph = cmark_node_new(CMARK_NODE_PARAGRAPH);
-    cmark_node_append_child(parent, paragraph);
+    w.enter_block(node_type::paragraph);
 
-    handle_children(paragraph, opt, t);
+    write_inline_children(w, t);
 
     if (desc)
     {
-        if (opt.use_html)
-        {
-            auto html = cmark_node_new(CMARK_NODE_HTML_INLINE);
-            cmark_node_set_literal(html, " &mdash; ");
-            cmark_node_append_child(paragraph, html);
-        }
+        if (w.opt().use_html)
+            w.html_inline(" &mdash; ");
         else
-        {
-            auto text = cmark_node_new(CMARK_NODE_TEXT);
-            cmark_node_set_literal(text, " - ");
-            cmark_node_append_child(paragraph, text);
-        }
+            w.text(" - ");
 
-        handle_children(paragraph, opt, *desc);
+        write_inline_children(w, *desc);
     }
+
+    w.exit_block();
 }
 
-void build_list_item(cmark_node* parent, const options& opt, const list_item_base& item)
+void write_list_item(markdown_writer& w, const list_item_base& item)
 {
-    auto li = cmark_node_new(CMARK_NODE_ITEM);
-    cmark_node_append_child(parent, li);
+    w.enter_block(node_type::item);
 
     if (item.kind() == entity_kind::list_item)
-        handle_children(li, opt, static_cast<const list_item&>(item));
+        write_children(w, static_cast<const list_item&>(item));
     else if (item.kind() == entity_kind::term_description_item)
     {
         auto& term        = static_cast<const term_description_item&>(item).term();
         auto& description = static_cast<const term_description_item&>(item).description();
-        build_term_description(li, opt, term, &description);
+        write_term_description(w, term, &description);
     }
     else
         assert(false);
+
+    w.exit_block();
 }
 
-void build(cmark_node* parent, const options& opt, const unordered_list& list)
+void write(markdown_writer& w, const unordered_list& list)
 {
-    auto ul = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(ul, CMARK_BULLET_LIST);
-    cmark_node_append_child(parent, ul);
-
+    w.enter_list(false, false);
     for (auto& item : list)
-        build_list_item(ul, opt, item);
+        write_list_item(w, item);
+    w.exit_block();
 }
 
-void build(cmark_node* parent, const options& opt, const ordered_list& list)
+void write(markdown_writer& w, const ordered_list& list)
 {
-    auto ul = cmark_node_new(CMARK_NODE_LIST);
-    cmark_node_set_list_type(ul, CMARK_ORDERED_LIST);
-    cmark_node_set_list_start(ul, 1);
-    cmark_node_append_child(parent, ul);
-
+    w.enter_list(true, false);
     for (auto& item : list)
-        build_list_item(ul, opt, item);
+        write_list_item(w, item);
+    w.exit_block();
 }
 
-void build(cmark_node* parent, const options& opt, const block_quote& quote)
+void write(markdown_writer& w, const block_quote& quote)
 {
-    auto node = cmark_node_new(CMARK_NODE_BLOCK_QUOTE);
-    cmark_node_append_child(parent, node);
-
-    handle_children(node, opt, quote);
+    w.enter_block(node_type::block_quote);
+    write_children(w, quote);
+    w.exit_block();
 }
 
-void build(cmark_node* parent, const options& opt, const code_block& cb)
+void write(markdown_writer& w, const code_block& cb)
 {
-    if (opt.use_html)
+    if (w.opt().use_html)
     {
-        auto node = cmark_node_new(CMARK_NODE_HTML_BLOCK);
-        cmark_node_append_child(parent, node);
-
-        auto html = render(html_generator(opt.prefix, opt.extension), cb);
-        cmark_node_set_literal(node, html.c_str());
+        auto html = render(html_generator(w.opt().prefix, w.opt().extension), cb);
+        w.html_block(html.c_str());
     }
     else
     {
-        auto node = cmark_node_new(CMARK_NODE_CODE_BLOCK);
-        cmark_node_append_child(parent, node);
-
-        if (!cb.language().empty())
-            cmark_node_set_fence_info(node, cb.language().c_str());
-
-        handle_children(node, opt, cb);
+        std::string code;
+        append_code_block_text(code, cb);
+        w.code_block(cb.language().c_str(), code);
     }
 }
 
-void append_code_block_text(cmark_node* cb, const std::string& text)
+void write(markdown_writer& w, const thematic_break&)
 {
-    auto str = cmark_node_get_literal(cb);
-    if (str)
-        cmark_node_set_literal(cb, (str + text).c_str());
-    else
-        cmark_node_set_literal(cb, text.c_str());
+    w.thematic_break();
 }
 
-void build(cmark_node* parent, const options&, const code_block::keyword& text)
+void write(markdown_writer& w, const text& t)
 {
-    append_code_block_text(parent, text.string());
+    w.text(t.string().c_str());
 }
 
-void build(cmark_node* parent, const options&, const code_block::identifier& text)
+void write(markdown_writer& w, const emphasis& emph, bool nested)
 {
-    append_code_block_text(parent, text.string());
+    // the delimiters are CommonMark only
+    auto delimiter = nested ? "_" : "*";
+    if (w.is_commonmark())
+        w.lit(delimiter);
+    write_inline_children(w, emph, true);
+    if (w.is_commonmark())
+        w.lit(delimiter);
 }
 
-void build(cmark_node* parent, const options&, const code_block::string_literal& text)
+void write(markdown_writer& w, const strong_emphasis& emph)
 {
-    append_code_block_text(parent, text.string());
+    if (w.is_commonmark())
+        w.lit("**");
+    write_inline_children(w, emph);
+    if (w.is_commonmark())
+        w.lit("**");
 }
 
-void build(cmark_node* parent, const options&, const code_block::int_literal& text)
+void write(markdown_writer& w, const code& c)
 {
-    append_code_block_text(parent, text.string());
+    std::string code;
+    append_code_text(code, c);
+    w.code(code);
 }
 
-void build(cmark_node* parent, const options&, const code_block::float_literal& text)
+void write(markdown_writer& w, const verbatim& v)
 {
-    append_code_block_text(parent, text.string());
+    // write inline HTML and hope it works
+    w.html_inline(v.content().c_str());
 }
 
-void build(cmark_node* parent, const options&, const code_block::punctuation& text)
+void write(markdown_writer& w, const soft_break&)
 {
-    append_code_block_text(parent, text.string());
+    w.soft_break();
 }
 
-void build(cmark_node* parent, const options&, const code_block::preprocessor& text)
+void write(markdown_writer& w, const hard_break&)
 {
-    append_code_block_text(parent, text.string());
+    w.hard_break();
 }
 
-void build(cmark_node* parent, const options&, const thematic_break&)
+std::string get_url(const options& opt, const documentation_link& link)
 {
-    auto node = cmark_node_new(CMARK_NODE_THEMATIC_BREAK);
-    cmark_node_append_child(parent, node);
-}
-
-void build(cmark_node* parent, const options&, const text& t)
-{
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK
-        || cmark_node_get_type(parent) == CMARK_NODE_CODE)
-        append_code_block_text(parent, t.string());
-    else
+    if (link.internal_destination())
     {
-        auto text = cmark_node_new(CMARK_NODE_TEXT);
-        cmark_node_append_child(parent, text);
-        cmark_node_set_literal(text, t.string().c_str());
+        auto url = opt.prefix
+                   + link.internal_destination()
+                         .value()
+                         .document()
+                         .map(&output_name::file_name, opt.extension.c_str())
+                         .value_or("");
+        url += "#standardese-" + link.internal_destination().value().id().as_output_str();
+        return url;
     }
+    else
+        return link.external_destination().value().as_str();
 }
 
-void build(cmark_node* parent, const options& opt, const emphasis& emph)
-{
-    auto node = cmark_node_new(CMARK_NODE_EMPH);
-    cmark_node_append_child(parent, node);
-
-    handle_children(node, opt, emph);
-}
-
-void build(cmark_node* parent, const options& opt, const strong_emphasis& emph)
+// whether the URL starts with a scheme, as cmark's autolinks
+bool has_scheme(const char* url)
 {
-    auto node = cmark_node_new(CMARK_NODE_STRONG);
-    cmark_node_append_child(parent, node);
-
-    handle_children(node, opt, emph);
+    if (!is_alpha(static_cast<unsigned char>(*url)))
+        return false;
+
+    auto length = 1u;
+    while (is_alpha(static_cast<unsigned char>(url[length]))
+           || is_digit(static_cast<unsigned char>(url[length])) || url[length] == '.'
+           || url[length] == '+' || url[length] == '-')
+        ++length;
+    return length >= 2u && length <= 32u && url[length] == ':';
 }
 
-void build(cmark_node* parent, const options& opt, const code& c)
+// the string cmark compares against the URL to detect an autolink
+std::string get_autolink_text(const options& opt, const entity& first)
 {
-    auto node = cmark_node_new(CMARK_NODE_CODE);
-    cmark_node_append_child(parent, node);
-    handle_children(node, opt, c);
+    std::string result;
+    if (first.kind() == entity_kind::code)
+        append_code_text(result, static_cast<const code&>(first));
+    else if (first.kind() == entity_kind::verbatim)
+        result = static_cast<const verbatim&>(first).content().c_str();
+    else if (first.kind() == entity_kind::external_link)
+        result = static_cast<const external_link&>(first).url().as_str().c_str();
+    else if (first.kind() == entity_kind::documentation_link)
+        result = get_url(opt, static_cast<const documentation_link&>(first)).c_str();
+    return result;
 }
 
-void build(cmark_node* parent, const options&, const verbatim& v)
+template <class Link>
+void write_link(markdown_writer& w, const char* title, const char* url, const Link& link)
 {
-    // build inline HTML and hope it works
-    auto node = cmark_node_new(CMARK_NODE_HTML_INLINE);
-    cmark_node_append_child(parent, node);
-    cmark_node_set_literal(node, v.content().c_str());
-}
+    if (!w.is_commonmark())
+    {
+        write_inline_children(w, link);
+        return;
+    }
 
-void build(cmark_node* parent, const options&, const soft_break&)
-{
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        append_code_block_text(parent, "\n");
-    else
+    // a link without title whose text is its URL is written as autolink,
+    // the texts at the beginning are merged like cmark does when it checks that
+    auto        merge_text = false;
+    std::string leading_text;
+    if (*title == '\0' && has_scheme(url))
     {
-        auto node = cmark_node_new(CMARK_NODE_SOFTBREAK);
-        cmark_node_append_child(parent, node);
+        const entity* first           = nullptr;
+        auto          in_leading_text = true;
+        for_each_inline(link, [&](const entity& child) {
+            if (!first)
+                first = &child;
+            if (in_leading_text && child.kind() == entity_kind::text)
+                leading_text += static_cast<const text&>(child).string().c_str();
+            else
+                in_leading_text = false;
+        });
+
+        if (first)
+        {
+            merge_text    = first->kind() == entity_kind::text;
+            auto url_text = std::strncmp(url, "mailto:", 7u) == 0 ? url + 7 : url;
+            if ((merge_text ? leading_text : get_autolink_text(w.opt(), *first)) == url_text)
+            {
+                w.lit("<");
+                w.lit(url_text);
+                w.lit(">");
+                return;
+            }
+        }
     }
-}
 
-void build(cmark_node* parent, const options&, const hard_break&)
-{
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        append_code_block_text(parent, "\n");
+    w.lit("[");
+    if (merge_text)
+    {
+        w.text(leading_text.c_str());
+
+        auto in_leading_text = true;
+        for_each_inline(link, [&](const entity& child) {
+            if (in_leading_text && child.kind() == entity_kind::text)
+                return;
+            in_leading_text = false;
+            write_inline(w, child, false);
+        });
+    }
     else
+        write_inline_children(w, link);
+    w.lit("](");
+    w.out(url, escaping::url);
+    if (*title != '\0')
     {
-        auto node = cmark_node_new(CMARK_NODE_LINEBREAK);
-        cmark_node_append_child(parent, node);
+        w.lit(" \"");
+        w.out(title, escaping::title);
+        w.lit("\"");
     }
+    w.lit(")");
 }
 
-cmark_node* build_link(const char* title, const char* url)
+void write(markdown_writer& w, const external_link& link)
 {
-    auto node = cmark_node_new(CMARK_NODE_LINK);
-    if (*title != '\0')
-        cmark_node_set_title(node, title);
-    cmark_node_set_url(node, url);
-
-    return node;
+    write_link(w, link.title().c_str(), link.url().as_str().c_str(), link);
 }
 
-void build(cmark_node* parent, const options& opt, const external_link& link)
+void write(markdown_writer& w, const documentation_link& link)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        handle_children(parent, opt, link);
-    else
+    if (has_destination(link))
     {
-        auto node = build_link(link.title().c_str(), link.url().as_str().c_str());
-        cmark_node_append_child(parent, node);
-
-        handle_children(node, opt, link);
+        auto url = get_url(w.opt(), link);
+        write_link(w, link.title().c_str(), url.c_str(), link);
     }
+    else
+        // only write link content
+        write_inline_children(w, link);
 }
 
-void build(cmark_node* parent, const options& opt, const documentation_link& link)
+void write_inline(markdown_writer& w, const entity& e, bool nested_emphasis)
 {
-    if (cmark_node_get_type(parent) == CMARK_NODE_CODE_BLOCK)
-        handle_children(parent, opt, link);
-    else if (link.internal_destination())
-    {
-        auto url = opt.prefix
-                   + link.internal_destination()
-                         .value()
-                         .document()
-                         .map(&output_name::file_name, opt.extension.c_str())
-                         .value_or("");
-        url += "#standardese-" + link.internal_destination().value().id().as_output_str();
-
-        auto node = build_link(link.title().c_str(), url.c_str());
-        cmark_node_append_child(parent, node);
-
-        handle_children(node, opt, link);
-    }
-    else if (link.external_destination())
-    {
-        auto url = link.external_destination().value().as_str();
-
-        auto node = build_link(link.title().c_str(), url.c_str());
-        cmark_node_append_child(parent, node);
-
-        handle_children(node, opt, link);
-    }
+    if (e.kind() == entity_kind::emphasis)
+        write(w, static_cast<const emphasis&>(e), nested_emphasis);
     else
-        // only write link content
-        handle_children(parent, opt, link);
+        write_entity(w, e);
 }
 
-void build_entity(cmark_node* parent, const options& opt, const entity& e)
+void write_entity(markdown_writer& w, const entity& e)
 {
     switch (e.kind())
     {
 #define STANDARDESE_DETAIL_HANDLE(Kind)                                                            \
     case entity_kind::Kind:                                                                        \
-        build(parent, opt, static_cast<const Kind&>(e));                                           \
-        break;
-#define STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(Kind)                                                 \
-    case entity_kind::code_block_##Kind:                                                           \
-        build(parent, opt, static_cast<const code_block::Kind&>(e));                               \
+        write(w, static_cast<const Kind&>(e));                                                     \
         break;
 
         STANDARDESE_DETAIL_HANDLE(file_documentation)
@@ -608,18 +1257,10 @@ void build_entity(cmark_node* parent, const options& opt, const entity& e)
         STANDARDESE_DETAIL_HANDLE(block_quote)
 
         STANDARDESE_DETAIL_HANDLE(code_block)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(keyword)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(identifier)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(string_literal)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(int_literal)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(float_literal)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(punctuation)
-        STANDARDESE_DETAIL_HANDLE_CODE_BLOCK(preprocessor)
 
         STANDARDESE_DETAIL_HANDLE(thematic_break)
 
         STANDARDESE_DETAIL_HANDLE(text)
-        STANDARDESE_DETAIL_HANDLE(emphasis)
         STANDARDESE_DETAIL_HANDLE(strong_emphasis)
         STANDARDESE_DETAIL_HANDLE(code)
         STANDARDESE_DETAIL_HANDLE(verbatim)
@@ -630,7 +1271,20 @@ void build_entity(cmark_node* parent, const options& opt, const entity& e)
         STANDARDESE_DETAIL_HANDLE(documentation_link)
 
 #undef STANDARDESE_DETAIL_HANDLE
-#undef STANDARDESE_DETAIL_HANDLE_CODE_BLOCK
+
+    case entity_kind::emphasis:
+        write(w, static_cast<const emphasis&>(e), false);
+        break;
+
+    case entity_kind::code_block_keyword:
+    case entity_kind::code_block_identifier:
+    case entity_kind::code_block_string_literal:
+    case entity_kind::code_block_int_literal:
+    case entity_kind::code_block_float_literal:
+    case entity_kind::code_block_punctuation:
+    case entity_kind::code_block_preprocessor:
+        // only written inside of a code block
+        break;
 
     case entity_kind::main_document:
     case entity_kind::subdocument:
@@ -650,18 +1304,28 @@ void build_entity(cmark_node* parent, const options& opt, const entity& e)
     }
 }
 
-cmark_node* build_entity(const options& opt, const entity& e)
+void write_markdown(output_sink& out, const options& opt, bool commonmark, const entity& e)
 {
-    auto doc = is_phrasing(e.kind()) ? cmark_node_new(CMARK_NODE_PARAGRAPH)
-                                     : cmark_node_new(CMARK_NODE_DOCUMENT);
+    markdown_writer w(out, opt, commonmark);
 
-    if (e.kind() == entity_kind::main_document || e.kind() == entity_kind::subdocument
-        || e.kind() == entity_kind::template_document)
-        handle_children(doc, opt, static_cast<const document_entity&>(e));
+    // phrasing entities are written in a paragraph, everything else in a document
+    if (is_phrasing(e.kind()))
+    {
+        w.enter_block(node_type::paragraph);
+        write_inline(w, e, false);
+    }
     else
-        build_entity(doc, opt, e);
+    {
+        w.enter_block(node_type::document);
+        if (e.kind() == entity_kind::main_document || e.kind() == entity_kind::subdocument
+            || e.kind() == entity_kind::template_document)
+            write_children(w, static_cast<const document_entity&>(e));
+        else
+            write_entity(w, e);
+    }
+    w.exit_block();
 
-    return doc;
+    w.finish();
 }
 } // namespace
 
@@ -669,27 +1333,11 @@ generator standardese::markup::markdown_generator(bool use_html, const std::stri
                                                   const std::string& extension) noexcept
 {
     options opt{prefix, extension, use_html};
-    return [opt](std::ostream& out, const entity& e) {
-        auto doc = build_entity(opt, e);
-
-        auto str = cmark_render_commonmark(doc, CMARK_OPT_NOBREAKS, 0);
-        out << str;
-        std::free(str);
-
-        cmark_node_free(doc);
-    };
+    return [opt](output_sink& out, const entity& e) { write_markdown(out, opt, true, e); };
 }
 
 generator standardese::markup::text_generator() noexcept
 {
     options opt{"", "txt", false};
-    return [opt](std::ostream& out, const entity& e) {
-        auto doc = build_entity(opt, e);
-
-        auto str = cmark_render_plaintext(doc, CMARK_OPT_NOBREAKS, 0);
-        out << str;
-        std::free(str);
-
-        cmark_node_free(doc);
-    };
+    return [opt](output_sink& out, const entity& e) { write_markdown(out, opt, false, e); };
 }
@@ -4,8 +4,6 @@
 
 #include <standardese/markup/generator.hpp>
 
-#include <ostream>
-
 #include <type_safe/flag.hpp>
 #include <type_safe/reference.hpp>
 
@@ -25,6 +23,8 @@
 #include <standardese/markup/quote.hpp>
 #include <standardese/markup/thematic_break.hpp>
 
+#include "escape.hpp"
+
 using namespace standardese::markup;
 
 namespace
@@ -32,7 +32,7 @@ namespace
 class xml_stream
 {
 public:
-    xml_stream(type_safe::object_ref<std::ostream> out, bool include_attributes = true)
+    xml_stream(type_safe::object_ref<detail::output_buffer> out, bool include_attributes = true)
     : out_(out), newl_(false), attributes_(include_attributes)
     {}
 
@@ -61,21 +61,23 @@ public:
     template <typename... Attributes>
     xml_stream open_tag(tag_kind kind, const char* tag, const Attributes&... attributes)
     {
-        *out_ << "<" << tag;
+        out_->put('<');
+        out_->write(tag);
 
         if (attributes_ == true)
         {
-            int fold_expr[]
-                = {(attributes.second.empty() ? 0
-                                              : (*out_ << " " << attributes.first << "=\"",
-                                                 write(attributes.second), *out_ << '"', 0))...,
-                   0};
+            int fold_expr[] = {(attributes.second.empty()
+                                    ? 0
+                                    : (out_->put(' '), out_->write(attributes.first),
+                                       out_->write("=\""), write(attributes.second),
+                                       out_->put('"'), 0))...,
+                               0};
             (void)fold_expr;
         }
 
-        *out_ << ">";
+        out_->put('>');
         if (kind == block_tag)
-            *out_ << '\n';
+            out_->put('\n');
         return xml_stream(*this, tag, kind != inline_tag);
     }
 
@@ -86,17 +88,17 @@ public:
         {
             auto c = *ptr;
             if (c == '&')
-                *out_ << "&amp;";
+                out_->write("&amp;", 5u);
             else if (c == '<')
-                *out_ << "&lt;";
+                out_->write("&lt;", 4u);
             else if (c == '>')
-                *out_ << "&gt;";
+                out_->write("&gt;", 4u);
             else if (c == '"')
-                *out_ << "&quot;";
+                out_->write("&quot;", 6u);
             else if (c == '\'')
-                *out_ << "&apos;";
+                out_->write("&apos;", 6u);
             else
-                *out_ << c;
+                out_->put(c);
         }
     }
 
@@ -108,7 +110,7 @@ public:
     // writes unescaped xml
     void write_xml(const char* str)
     {
-        *out_ << str;
+        out_->write(str);
     }
 
 private:
@@ -122,16 +124,18 @@ private:
             newl_.reset();
         else
         {
-            *out_ << "</" << closing_ << ">";
+            out_->write("</", 2u);
+            out_->write(closing_.data(), closing_.size());
+            out_->put('>');
             if (newl_.try_reset())
-                *out_ << "\n";
+                out_->put('\n');
             closing_.clear();
         }
     }
 
-    std::string                         closing_;
-    type_safe::object_ref<std::ostream> out_;
-    type_safe::flag                     newl_, attributes_;
+    std::string                                  closing_;
+    type_safe::object_ref<detail::output_buffer> out_;
+    type_safe::flag                              newl_, attributes_;
 };
 
 void write_entity(xml_stream& s, const entity& e);
@@ -556,13 +560,21 @@ void write_entity(xml_stream& s, const entity& e)
 generator standardese::markup::xml_generator(bool include_attributes) noexcept
 {
     if (include_attributes)
-        return [](std::ostream& out, const entity& e) {
-            xml_stream s(type_safe::ref(out));
-            write_entity(s, e);
+        return [](output_sink& out, const entity& e) {
+            detail::output_buffer buffer(out);
+            {
+                xml_stream s(type_safe::ref(buffer));
+                write_entity(s, e);
+            }
+            buffer.flush();
         };
     else
-        return [](std::ostream& out, const entity& e) {
-            xml_stream s(type_safe::ref(out), false);
-            write_entity(s, e);
+        return [](output_sink& out, const entity& e) {
+            detail::output_buffer buffer(out);
+            {
+                xml_stream s(type_safe::ref(buffer), false);
+                write_entity(s, e);
+            }
+            buffer.flush();
         };
 }
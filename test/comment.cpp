@@ -6,6 +6,9 @@
 
 #include <catch.hpp>
 #include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <cppast/cpp_class.hpp>
 #include <cppast/cpp_function.hpp>
@@ -184,6 +187,16 @@ struct c : foo<int> {};
 
             return true;
         });
+
+        for (auto& e : *file)
+            if (e.name() == "a")
+            {
+                // from a remote comment
+                REQUIRE(registry.get_remote_file(e));
+                REQUIRE(registry.get_remote_file(e).value() == file->name());
+            }
+            else if (e.name() == "foo")
+                REQUIRE(!registry.get_remote_file(e));
     }
     SECTION("member groups")
     {
@@ -210,6 +223,8 @@ void a(float);
         file_comment_parser parser(test_logger());
         parser.parse(type_safe::ref(*file));
         auto groups = parser.finish();
+        REQUIRE(groups.no_groups() == 3u);
+        REQUIRE(groups.no_comments() == 6u);
 
         auto a = groups.lookup_group("a");
         REQUIRE((a.size() == 3u));
@@ -226,6 +241,62 @@ void a(float);
         for (auto entity : c)
             REQUIRE(entity->name() == "c");
     }
+    SECTION("parallel")
+    {
+        // f() is declared in every file, so the remote comment is ambiguous
+        std::vector<std::unique_ptr<cppast::cpp_file>> files;
+        for (auto i = 0; i != 4; ++i)
+        {
+            auto name   = "comment_parallel_" + std::to_string(i) + ".cpp";
+            std::string source;
+            if (i == 2)
+                source += "/// \\entity f()\n/// \\module remote\n/// Remote.\n\n";
+            source += "/// \\module m" + std::to_string(i) + "\n\nvoid f();\n";
+            files.push_back(parse_file({}, name.c_str(), source.c_str()));
+        }
+
+        auto parse_in_parallel = [&](bool reverse) {
+            file_comment_parser parser(test_logger());
+            {
+                std::vector<std::thread> threads;
+                for (auto i = 0u; i != files.size(); ++i)
+                {
+                    auto& file = *files[reverse ? files.size() - 1u - i : i];
+                    threads.emplace_back([&parser, &file] { parser.parse(type_safe::ref(file)); });
+                }
+                for (auto& thread : threads)
+                    thread.join();
+            }
+            auto registry = parser.finish();
+
+            std::string result;
+            for (auto& file : files)
+            {
+                auto comment = registry.get_comment(get_named_entity(*file, "f"));
+                REQUIRE(comment);
+                result += file->name();
+                if (comment.value().metadata().module() == std::string("remote"))
+                    result += " remote";
+                if (comment.value().brief_section())
+                    result += " brief";
+                result += '\n';
+            }
+            for (auto i = 0; i != 4; ++i)
+                if (registry.get_comment("m" + std::to_string(i)))
+                    result += "m" + std::to_string(i) + '\n';
+            return result;
+        };
+
+        // the first declaration by file name and position gets the comment,
+        // no matter the order the files were parsed in
+        auto expected = "comment_parallel_0.cpp remote brief\n"
+                        "comment_parallel_1.cpp remote\n"
+                        "comment_parallel_2.cpp remote\n"
+                        "comment_parallel_3.cpp remote\n"
+                        "m0\nm1\nm2\nm3\n";
+        for (auto i = 0; i != 8; ++i)
+            REQUIRE(parse_in_parallel(i % 2 == 1) == expected);
+    }
     SECTION("module")
     {
         // set synopsis to same name as module
@@ -4,6 +4,8 @@
 
 #include <standardese/linker.hpp>
 
+#include <thread>
+
 #include <catch.hpp>
 
 #include <standardese/markup/document.hpp>
@@ -69,6 +71,24 @@ TEST_CASE("linker")
         REQUIRE(equal_destination(l.lookup_documentation(nullptr, "foo"), *document_b,
                                   markup::block_id("foo")));
     }
+    SECTION("frozen")
+    {
+        REQUIRE(l.register_documentation("foo", *document_a, markup::block_id("foo"), false));
+        REQUIRE(l.register_documentation("foo<T>::bar(int)", *document_b, markup::block_id("bar"),
+                                         false));
+        REQUIRE(!l.is_frozen());
+
+        l.freeze();
+        REQUIRE(l.is_frozen());
+
+        REQUIRE(equal_destination(l.lookup_documentation(nullptr, "foo"), *document_a,
+                                  markup::block_id("foo")));
+        REQUIRE(equal_destination(l.lookup_documentation(nullptr, "foo<T>::bar(int)"),
+                                  *document_b, markup::block_id("bar")));
+        REQUIRE(equal_destination(l.lookup_documentation(nullptr, "foo::bar"), *document_b,
+                                  markup::block_id("bar")));
+        REQUIRE(!l.lookup_documentation(nullptr, "bar"));
+    }
     SECTION("short and long link names")
     {
         REQUIRE(l.register_documentation("foo()", *document_a, markup::block_id("foo"), false));
@@ -96,6 +116,34 @@ TEST_CASE("linker")
                                   *document_a, markup::block_id("baz2")));
         REQUIRE(!l.lookup_documentation(nullptr, "foo::baz"));
     }
+    SECTION("concurrent registration")
+    {
+        // both names of a registration are updated together,
+        // so the long and the short name refer to the same documentation
+        std::vector<std::thread> threads;
+        for (auto t = 0; t != 4; ++t)
+            threads.emplace_back([&, t] {
+                auto& document = t % 2 == 0 ? *document_a : *document_b;
+                for (auto i = 0; i != 100; ++i)
+                    l.register_documentation("ns" + std::to_string(i) + "::f(int)", document,
+                                             markup::block_id("f" + std::to_string(t)), true);
+            });
+        for (auto& thread : threads)
+            thread.join();
+
+        for (auto i = 0; i != 100; ++i)
+        {
+            auto name       = "ns" + std::to_string(i) + "::f";
+            auto long_dest  = l.lookup_documentation(nullptr, name + "(int)");
+            auto short_dest = l.lookup_documentation(nullptr, name);
+            REQUIRE(long_dest.has_value(type_safe::variant_type<markup::block_reference>{}));
+            REQUIRE(short_dest.has_value(type_safe::variant_type<markup::block_reference>{}));
+
+            auto& long_ref  = long_dest.value(type_safe::variant_type<markup::block_reference>{});
+            auto& short_ref = short_dest.value(type_safe::variant_type<markup::block_reference>{});
+            REQUIRE(long_ref.id() == short_ref.id());
+        }
+    }
     SECTION("relative name lookup")
     {
         auto file = parse_file({}, "linker__relative_name_lookup.cpp", R"(
@@ -146,6 +194,30 @@ void context3();
         auto& context3 = get_named_entity(*file, "context3");
         REQUIRE(equal_destination(l.lookup_documentation(type_safe::ref(context3), "*func"),
                                   *document_a, markup::block_id("func")));
+
+        // lookup using the captured scope
+        REQUIRE(equal_destination(l.lookup_documentation(get_link_scope(context1), "*mfunc"),
+                                  *document_a, markup::block_id("ns::type::mfunc")));
+        REQUIRE(equal_destination(l.lookup_documentation(get_link_scope(context2), "*func"),
+                                  *document_a, markup::block_id("ns::func")));
+        REQUIRE(equal_destination(l.lookup_documentation(get_link_scope(context3), "*func"),
+                                  *document_a, markup::block_id("func")));
+
+        // lookup using a context, the second lookup is cached
+        l.freeze();
+        linker::lookup_context context(get_link_scope(context1));
+        for (auto i = 0; i != 2; ++i)
+        {
+            REQUIRE(equal_destination(l.lookup_documentation(context, "*mfunc"), *document_a,
+                                      markup::block_id("ns::type::mfunc")));
+            REQUIRE(equal_destination(l.lookup_documentation(context, "*func"), *document_a,
+                                      markup::block_id("ns::func")));
+            REQUIRE(equal_destination(l.lookup_documentation(context, "func"), *document_a,
+                                      markup::block_id("func")));
+        }
+
+        linker::lookup_context no_context;
+        REQUIRE(!l.lookup_documentation(no_context, "*func"));
     }
     SECTION("external doc")
     {
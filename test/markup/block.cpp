@@ -0,0 +1,110 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/block.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <catch.hpp>
+
+#include <cppast/cpp_file.hpp>
+#include <standardese/markup/code_block.hpp>
+#include <standardese/markup/documentation.hpp>
+#include <standardese/markup/heading.hpp>
+
+using namespace standardese::markup;
+
+TEST_CASE("block_id", "[markup]")
+{
+    SECTION("interning")
+    {
+        block_id a("a"), b("b");
+        REQUIRE(a == block_id("a"));
+        REQUIRE(a != b);
+        REQUIRE(&a.as_str() == &block_id(std::string("a")).as_str());
+        REQUIRE(a.as_str() == "a");
+
+        REQUIRE(block_id().empty());
+        REQUIRE(block_id() == block_id(""));
+        REQUIRE(!a.empty());
+    }
+    SECTION("escaping")
+    {
+        REQUIRE(block_id("foo-bar_42").as_output_str() == "foo-bar_42");
+        REQUIRE(block_id("a::b(int c)").as_output_str() == "a__b-int-c-");
+        REQUIRE(block_id("a::b(int c)").as_str() == "a::b(int c)");
+        REQUIRE(&block_id("a<T>").as_output_str() == &block_id("a<T>").as_output_str());
+    }
+    SECTION("output_name")
+    {
+        auto name = output_name::from_name("doc_foo");
+        REQUIRE(name.needs_extension());
+        REQUIRE(name.name() == "doc_foo");
+        REQUIRE(name.file_name("md") == "doc_foo.md");
+        REQUIRE(&name.name() == &output_name::from_file_name("doc_foo").name());
+        REQUIRE(output_name::from_file_name("doc_foo.md").file_name("html") == "doc_foo.md");
+    }
+    SECTION("threads")
+    {
+        // every thread interns the same strings, in a different order
+        std::vector<std::vector<block_id>> ids(4u);
+        std::vector<std::thread>           threads;
+        for (auto t = 0u; t != ids.size(); ++t)
+            threads.emplace_back([&, t] {
+                for (auto i = 0u; i != 1000u; ++i)
+                    ids[t].emplace_back("threads-" + std::to_string(t % 2u == 0u ? i : 999u - i));
+            });
+        for (auto& thread : threads)
+            thread.join();
+
+        for (auto i = 0u; i != 1000u; ++i)
+        {
+            REQUIRE(ids[0][i] == ids[2][i]);
+            REQUIRE(ids[0][i] == ids[1][999u - i]);
+            REQUIRE(ids[0][i] == ids[3][999u - i]);
+            REQUIRE(ids[0][i].as_str() == "threads-" + std::to_string(i));
+        }
+    }
+}
+
+TEST_CASE("brief_section id", "[markup]")
+{
+    cppast::cpp_file::builder file("foo");
+
+    auto build = [&](const char* id) {
+        file_documentation::builder builder(type_safe::ref(file.get()), block_id(id),
+                                            heading::build(block_id(), "A file"),
+                                            code_block::build(block_id(), "cpp", "void foo();"));
+        builder.add_brief(brief_section::builder().finish());
+        return builder.finish();
+    };
+
+    REQUIRE(brief_section::builder().finish()->id().empty());
+
+    auto a = build("a::b");
+    auto b = build("c");
+    REQUIRE(a->brief_section().value().id() == block_id("a::b-brief"));
+    REQUIRE(a->brief_section().value().id().as_output_str() == "a__b-brief");
+    REQUIRE(b->brief_section().value().id() == block_id("c-brief"));
+
+    // the copy has its own parent
+    auto copy = a->clone();
+    REQUIRE(static_cast<const file_documentation&>(*copy).brief_section().value().id()
+            == block_id("a::b-brief"));
+
+    // the parent doesn't change, so concurrent calls are fine
+    std::atomic<bool>        correct(true);
+    std::vector<std::thread> threads;
+    for (auto i = 0; i != 4; ++i)
+        threads.emplace_back([&] {
+            for (auto j = 0; j != 100; ++j)
+                if (b->brief_section().value().id() != block_id("c-brief"))
+                    correct = false;
+        });
+    for (auto& thread : threads)
+        thread.join();
+    REQUIRE(correct);
+}
@@ -0,0 +1,47 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/entity_arena.hpp>
+
+#include <thread>
+
+#include <catch.hpp>
+
+#include <standardese/markup/document.hpp>
+#include <standardese/markup/generator.hpp>
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/phrasing.hpp>
+
+using namespace standardese::markup;
+
+TEST_CASE("entity_arena", "[markup]")
+{
+    std::unique_ptr<document_entity> doc;
+    std::unique_ptr<paragraph>       survivor;
+    {
+        entity_arena arena;
+
+        subdocument::builder builder("title", "doc");
+        for (auto i = 0; i != 1000; ++i)
+            builder.add_child(paragraph::builder().add_child(text::build("a")).finish());
+        doc = builder.finish();
+
+        // nested arena and an entity that outlives the document
+        {
+            entity_arena nested;
+            survivor = paragraph::builder().add_child(emphasis::build("b")).finish();
+        }
+    }
+
+    REQUIRE(as_markdown(*survivor) == "*b*\n");
+    auto expected = std::string("a\n");
+    for (auto i = 1; i != 1000; ++i)
+        expected += "\na\n";
+    REQUIRE(as_markdown(*doc) == expected);
+
+    // freed on a different thread
+    std::thread thread([&] { doc.reset(); });
+    thread.join();
+    REQUIRE(as_markdown(*survivor) == "*b*\n");
+}
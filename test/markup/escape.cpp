@@ -0,0 +1,98 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <stdexcept>
+
+#include <catch.hpp>
+
+#include <standardese/markup/document.hpp>
+#include <standardese/markup/generator.hpp>
+#include <standardese/markup/link.hpp>
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/phrasing.hpp>
+
+using namespace standardese::markup;
+
+namespace
+{
+std::string escape_html(const std::string& str)
+{
+    std::string result;
+    for (auto c : str)
+        switch (c)
+        {
+        case '&':
+            result += "&amp;";
+            break;
+        case '<':
+            result += "&lt;";
+            break;
+        case '>':
+            result += "&gt;";
+            break;
+        case '"':
+            result += "&quot;";
+            break;
+        case '\'':
+            result += "&#x27;";
+            break;
+        case '/':
+            result += "&#x2F;";
+            break;
+        default:
+            result += c;
+            break;
+        }
+    return result;
+}
+} // namespace
+
+TEST_CASE("html escaping", "[markup]")
+{
+    SECTION("text")
+    {
+        // the special characters are in the blocks of 16 characters and in the rest
+        for (auto special : {'&', '<', '>', '"', '\'', '/'})
+            for (auto pos = 0u; pos != 40u; ++pos)
+            {
+                std::string str(40u, 'a');
+                str[pos]       = special;
+                str[39u - pos] = '\xE4'; // non-ASCII byte, not escaped
+                INFO(str);
+                REQUIRE(as_html(*text::build(str)) == escape_html(str));
+            }
+
+        std::string all = "\xC3\xA4\xC3\xB6<>&\"'/\xE2\x82\xAC plain text that is long enough /";
+        REQUIRE(as_html(*text::build(all)) == escape_html(all));
+        REQUIRE(as_html(*text::build("")) == "");
+    }
+    SECTION("url")
+    {
+        external_link::builder link(url("foo/\xC3\xA4 \x7F\xFF?a=b&c"));
+        link.add_child(text::build("link"));
+        REQUIRE(as_html(*link.finish()) == "<a href=\"foo/%C3%A4%20%7F%FF?a=b&amp;c\">link</a>");
+    }
+}
+
+TEST_CASE("generator errors", "[markup]")
+{
+    class throwing_output : public output_sink
+    {
+        void do_write(const char*, std::size_t) override
+        {
+            throw std::runtime_error("error");
+        }
+    };
+
+    // big enough that the buffer is written while the document is generated
+    subdocument::builder builder("title", "doc");
+    for (auto i = 0; i != 1000; ++i)
+        builder.add_child(paragraph::builder().add_child(text::build("some text")).finish());
+    auto doc = builder.finish();
+
+    throwing_output out;
+    REQUIRE_THROWS_AS(html_generator("", "html")(out, *doc), std::runtime_error);
+    REQUIRE_THROWS_AS(xml_generator()(out, *doc), std::runtime_error);
+    REQUIRE_THROWS_AS(xml_generator()(out, *text::build("short")), std::runtime_error);
+}
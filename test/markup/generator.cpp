@@ -0,0 +1,160 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/generator.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+#include <catch.hpp>
+
+#include <standardese/markup/phrasing.hpp>
+
+using namespace standardese::markup;
+
+namespace
+{
+std::string read_file(const char* path)
+{
+    std::ifstream file(path, std::ios_base::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+} // namespace
+
+TEST_CASE("string_output", "[markup]")
+{
+    string_output output(16u);
+    REQUIRE(output.str().empty());
+
+    output.write("Hello", 5u);
+    output.write(" World!", 7u);
+    REQUIRE(output.str() == "Hello World!");
+
+    auto str = output.release();
+    REQUIRE(str == "Hello World!");
+
+    output.write("a", 1u);
+    REQUIRE(output.str() == "a");
+}
+
+TEST_CASE("stream_output", "[markup]")
+{
+    std::ostringstream stream;
+    stream_output      output(stream);
+    output.write("Hello World!", 12u);
+    REQUIRE(stream.str() == "Hello World!");
+
+    html_generator("", "html")(stream, *text::build("<>"));
+    REQUIRE(stream.str() == "Hello World!&lt;&gt;");
+}
+
+TEST_CASE("file_output", "[markup]")
+{
+    auto path = "file_output.txt";
+
+    SECTION("small")
+    {
+        file_output output(path);
+        output.write("Hello", 5u);
+        output.write(" World!", 7u);
+        output.close();
+        REQUIRE(read_file(path) == "Hello World!");
+
+        // closing twice does nothing, writing afterwards is an error
+        output.close();
+        REQUIRE_THROWS_AS(output.write("a", 1u), std::logic_error);
+    }
+    SECTION("big")
+    {
+        // bigger than the buffer, written in pieces and at once
+        std::string expected;
+        {
+            file_output output(path);
+            for (auto i = 0; i != 100000; ++i)
+            {
+                auto str = std::to_string(i) + '\n';
+                output.write(str.c_str(), str.size());
+                expected += str;
+            }
+
+            std::string big(200000u, 'a');
+            output.write(big.c_str(), big.size());
+            expected += big;
+            // destructor writes the rest
+        }
+        REQUIRE(read_file(path) == expected);
+    }
+    SECTION("truncate")
+    {
+        {
+            file_output output(path);
+            output.write("a long line", 11u);
+        }
+        file_output output(path);
+        output.write("short", 5u);
+        output.close();
+        REQUIRE(read_file(path) == "short");
+    }
+    SECTION("error")
+    {
+        REQUIRE_THROWS_AS(file_output("file_output/does/not/exist.txt"), std::runtime_error);
+    }
+
+    std::remove(path);
+}
+
+TEST_CASE("generator", "[markup]")
+{
+    SECTION("empty")
+    {
+        REQUIRE(!generator());
+        REQUIRE(!generator(nullptr));
+        REQUIRE(generator(html_generator("", "html")));
+    }
+    SECTION("output_sink")
+    {
+        generator gen([](output_sink& out, const entity&) { out.write("sink", 4u); });
+        REQUIRE(render(gen, *text::build("")) == "sink");
+
+        std::ostringstream stream;
+        gen(stream, *text::build(""));
+        REQUIRE(stream.str() == "sink");
+    }
+    SECTION("std::ostream")
+    {
+        // generators of previous versions take a std::ostream
+        generator gen([](std::ostream& out, const entity& e) {
+            out << "stream: " << as_xml(e) << '\n';
+            for (auto i = 0; i != 1000; ++i)
+                out << i << ' ';
+        });
+
+        auto expected = std::string("stream: text\n");
+        for (auto i = 0; i != 1000; ++i)
+            expected += std::to_string(i) + ' ';
+        REQUIRE(render(gen, *text::build("text")) == expected);
+
+        std::ostringstream stream;
+        gen(stream, *text::build("text"));
+        REQUIRE(stream.str() == expected);
+    }
+    SECTION("errors")
+    {
+        class throwing_output : public output_sink
+        {
+            void do_write(const char*, std::size_t) override
+            {
+                throw std::runtime_error("error");
+            }
+        };
+
+        throwing_output out;
+        generator       gen([](std::ostream& out, const entity&) { out << "output"; });
+        REQUIRE_THROWS_AS(gen(out, *text::build("")), std::runtime_error);
+    }
+}
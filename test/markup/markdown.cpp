@@ -0,0 +1,499 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include <standardese/markup/generator.hpp>
+
+#include <catch.hpp>
+
+#include <cstdlib>
+#include <initializer_list>
+
+#include <cmark-gfm.h>
+
+#include <cppast/cpp_file.hpp>
+#include <cppast/cpp_namespace.hpp>
+#include <standardese/markup/code_block.hpp>
+#include <standardese/markup/doc_section.hpp>
+#include <standardese/markup/document.hpp>
+#include <standardese/markup/documentation.hpp>
+#include <standardese/markup/heading.hpp>
+#include <standardese/markup/index.hpp>
+#include <standardese/markup/link.hpp>
+#include <standardese/markup/list.hpp>
+#include <standardese/markup/paragraph.hpp>
+#include <standardese/markup/phrasing.hpp>
+#include <standardese/markup/quote.hpp>
+#include <standardese/markup/thematic_break.hpp>
+
+using namespace standardese::markup;
+
+// the markdown and text generators don't use cmark,
+// but their output has to be the same as the one of cmark's renderers for the equivalent tree
+namespace
+{
+// null children are skipped, they're the nodes only written with HTML
+cmark_node* build_node(cmark_node_type type, std::initializer_list<cmark_node*> children = {})
+{
+    auto node = cmark_node_new(type);
+    for (auto child : children)
+        if (child)
+            cmark_node_append_child(node, child);
+    return node;
+}
+
+cmark_node* build_literal(cmark_node_type type, const char* literal)
+{
+    auto node = cmark_node_new(type);
+    cmark_node_set_literal(node, literal);
+    return node;
+}
+
+cmark_node* build_text(const char* literal)
+{
+    return build_literal(CMARK_NODE_TEXT, literal);
+}
+
+cmark_node* build_heading(int level, std::initializer_list<cmark_node*> children)
+{
+    auto node = build_node(CMARK_NODE_HEADING, children);
+    cmark_node_set_heading_level(node, level);
+    return node;
+}
+
+cmark_node* build_code_block(const char* info, const char* code)
+{
+    auto node = build_literal(CMARK_NODE_CODE_BLOCK, code);
+    if (*info != '\0')
+        cmark_node_set_fence_info(node, info);
+    return node;
+}
+
+cmark_node* build_link(const char* url, const char* title,
+                       std::initializer_list<cmark_node*> children)
+{
+    auto node = build_node(CMARK_NODE_LINK, children);
+    if (*title != '\0')
+        cmark_node_set_title(node, title);
+    cmark_node_set_url(node, url);
+    return node;
+}
+
+cmark_node* build_list(cmark_list_type type, std::initializer_list<cmark_node*> items)
+{
+    auto node = build_node(CMARK_NODE_LIST, items);
+    cmark_node_set_list_type(node, type);
+    if (type == CMARK_ORDERED_LIST)
+        cmark_node_set_list_start(node, 1);
+    return node;
+}
+
+cmark_node* build_paragraph(const char* str)
+{
+    return build_node(CMARK_NODE_PARAGRAPH, {build_text(str)});
+}
+
+// the anchor of a documentation entity, only written with HTML
+cmark_node* build_anchor(bool use_html, const char* id)
+{
+    if (!use_html)
+        return nullptr;
+    return build_literal(CMARK_NODE_HTML_BLOCK,
+                         (std::string("<span id=\"standardese-") + id + "\"></span>\n").c_str());
+}
+
+cmark_node* build_synopsis(bool use_html, const char* code)
+{
+    if (!use_html)
+        return build_code_block("cpp", code);
+
+    auto html = render(html_generator("pre/", "md"), *code_block::build(block_id(), "cpp", code));
+    return build_literal(CMARK_NODE_HTML_BLOCK, html.c_str());
+}
+
+// a term followed by its description
+cmark_node* build_term(bool use_html, const char* term, const char* desc)
+{
+    auto node = build_node(CMARK_NODE_PARAGRAPH, {build_text(term)});
+    if (desc)
+    {
+        cmark_node_append_child(node, use_html ? build_literal(CMARK_NODE_HTML_INLINE, " &mdash; ")
+                                               : build_text(" - "));
+        cmark_node_append_child(node, build_text(desc));
+    }
+    return node;
+}
+
+// compares the generators with cmark's renderers, takes ownership of the tree
+// the text generator has no HTML option, so it is only compared without HTML
+void check_output(const entity& e, cmark_node* tree, bool use_html = false)
+{
+    auto commonmark = cmark_render_commonmark(tree, CMARK_OPT_NOBREAKS, 0);
+    auto plaintext  = cmark_render_plaintext(tree, CMARK_OPT_NOBREAKS, 0);
+    std::string expected_markdown(commonmark), expected_text(plaintext);
+    std::free(commonmark);
+    std::free(plaintext);
+    cmark_node_free(tree);
+
+    INFO("reference: cmark-gfm " << cmark_version_string());
+    REQUIRE(render(markdown_generator(use_html, "pre/", "md"), e) == expected_markdown);
+    if (!use_html)
+        REQUIRE(as_text(e) == expected_text);
+}
+} // namespace
+
+TEST_CASE("markdown_generator escaping", "[markup]")
+{
+    auto str = "- *a* _b_ [c] <d> #e f&g & h \\ !i ~j \xc3\xa4";
+    auto par = paragraph::builder()
+                   .add_child(text::build(str))
+                   .add_child(soft_break::build())
+                   .add_child(text::build("1. one 2) two"))
+                   .add_child(hard_break::build())
+                   .add_child(text::build("+3 =4 10) ten"))
+                   .add_child(soft_break::build())
+                   .add_child(text::build("line\n1) next"))
+                   .finish();
+    check_output(*par,
+                 build_node(CMARK_NODE_DOCUMENT,
+                            {build_node(CMARK_NODE_PARAGRAPH,
+                                        {build_text(str),
+                                         build_node(CMARK_NODE_SOFTBREAK),
+                                         build_text("1. one 2) two"),
+                                         build_node(CMARK_NODE_LINEBREAK),
+                                         build_text("+3 =4 10) ten"),
+                                         build_node(CMARK_NODE_SOFTBREAK),
+                                         build_text("line\n1) next")})}));
+}
+
+TEST_CASE("markdown_generator phrasing", "[markup]")
+{
+    auto par = paragraph::builder()
+                   .add_child(emphasis::builder().add_child(emphasis::build("nested")).finish())
+                   .add_child(strong_emphasis::build("strong"))
+                   .add_child(code::build("a`b``c"))
+                   .add_child(text::build(" "))
+                   .add_child(code::build("`"))
+                   .add_child(code::build(" padded "))
+                   .add_child(verbatim::build("<br/>"))
+                   .finish();
+    check_output(*par,
+                 build_node(CMARK_NODE_DOCUMENT,
+                            {build_node(CMARK_NODE_PARAGRAPH,
+                                        {build_node(CMARK_NODE_EMPH,
+                                                    {build_node(CMARK_NODE_EMPH,
+                                                                {build_text("nested")})}),
+                                         build_node(CMARK_NODE_STRONG, {build_text("strong")}),
+                                         build_literal(CMARK_NODE_CODE, "a`b``c"),
+                                         build_text(" "),
+                                         build_literal(CMARK_NODE_CODE, "`"),
+                                         build_literal(CMARK_NODE_CODE, " padded "),
+                                         build_literal(CMARK_NODE_HTML_INLINE, "<br/>")})}));
+
+    // phrasing entities are rendered on their own in a paragraph
+    auto emph = emphasis::build("*emph*");
+    check_output(*emph, build_node(CMARK_NODE_PARAGRAPH,
+                                   {build_node(CMARK_NODE_EMPH, {build_text("*emph*")})}));
+}
+
+TEST_CASE("markdown_generator links", "[markup]")
+{
+    auto par
+        = paragraph::builder()
+              .add_child(external_link::builder("a \"title\"", url("http://foo.com/a b(c)\\"))
+                             .add_child(text::build("link"))
+                             .finish())
+              .add_child(text::build(" "))
+              .add_child(external_link::builder(url("http://foo.com"))
+                             .add_child(text::build("http://foo.com"))
+                             .finish())
+              .add_child(text::build(" "))
+              .add_child(external_link::builder(url("mailto:foo@bar.com"))
+                             .add_child(text::build("foo@"))
+                             .add_child(text::build("bar.com"))
+                             .finish())
+              .add_child(text::build(" "))
+              .add_child(documentation_link::builder(
+                             "", block_reference(output_name::from_name("doc"), block_id("foo")))
+                             .add_child(text::build("internal"))
+                             .finish())
+              .add_child(text::build(" "))
+              .add_child(documentation_link::builder("unresolved")
+                             .add_child(text::build("unresolved"))
+                             .finish())
+              .finish();
+    check_output(*par,
+                 build_node(CMARK_NODE_DOCUMENT,
+                            {build_node(CMARK_NODE_PARAGRAPH,
+                                        {build_link("http://foo.com/a b(c)\\", "a \"title\"",
+                                                    {build_text("link")}),
+                                         build_text(" "),
+                                         build_link("http://foo.com", "",
+                                                    {build_text("http://foo.com")}),
+                                         build_text(" "),
+                                         build_link("mailto:foo@bar.com", "",
+                                                    {build_text("foo@"), build_text("bar.com")}),
+                                         build_text(" "),
+                                         build_link("pre/doc.md#standardese-foo", "",
+                                                    {build_text("internal")}),
+                                         build_text(" "),
+                                         build_text("unresolved")})}));
+}
+
+TEST_CASE("markdown_generator blocks", "[markup]")
+{
+    main_document::builder builder("title", "doc");
+    builder.add_child(heading::build(block_id(), "A heading"));
+    builder.add_child(subheading::build(block_id(), "A subheading"));
+    builder.add_child(thematic_break::build());
+    builder.add_child(code_block::build(block_id(), "", "int a;\nint b;\n"));
+    builder.add_child(code_block::build(block_id(), "cpp", "```\ncode\n"));
+    builder.add_child(code_block::build(block_id(), "c`pp", "code\n"));
+    builder.add_child(block_quote::builder(block_id())
+                          .add_child(paragraph::builder().add_child(text::build("quote")).finish())
+                          .add_child(code_block::build(block_id(), "", "   quoted code\n"))
+                          .finish());
+    auto doc = builder.finish();
+
+    check_output(*doc,
+                 build_node(CMARK_NODE_DOCUMENT,
+                            {build_heading(4, {build_text("A heading")}),
+                             build_heading(5, {build_text("A subheading")}),
+                             build_node(CMARK_NODE_THEMATIC_BREAK),
+                             build_code_block("", "int a;\nint b;\n"),
+                             build_code_block("cpp", "```\ncode\n"),
+                             build_code_block("c`pp", "code\n"),
+                             build_node(CMARK_NODE_BLOCK_QUOTE,
+                                        {build_node(CMARK_NODE_PARAGRAPH, {build_text("quote")}),
+                                         build_code_block("", "   quoted code\n")})}));
+}
+
+TEST_CASE("markdown_generator lists", "[markup]")
+{
+    auto par = [](const char* str) {
+        return paragraph::builder().add_child(text::build(str)).finish();
+    };
+    auto cmark_item = [](const char* str) {
+        return build_node(CMARK_NODE_ITEM,
+                          {build_node(CMARK_NODE_PARAGRAPH, {build_text(str)})});
+    };
+
+    main_document::builder builder("title", "doc");
+    builder.add_child(
+        unordered_list::builder(block_id())
+            .add_item(list_item::builder()
+                          .add_child(par("outer"))
+                          .add_child(unordered_list::builder(block_id())
+                                         .add_item(list_item::build(par("inner")))
+                                         .add_item(list_item::build(par("- inner")))
+                                         .finish())
+                          .finish())
+            .add_item(list_item::build(code_block::build(block_id(), "", "first in item\n")))
+            .add_item(term_description_item::build(block_id(), term::build(text::build("term")),
+                                                   description::build(text::build("desc"))))
+            .finish());
+    builder.add_child(code_block::build(block_id(), "", "after list\n"));
+
+    ordered_list::builder ordered(block_id("ordered"));
+    for (auto i = 0; i != 10; ++i)
+        ordered.add_item(list_item::build(par("item")));
+    builder.add_child(ordered.finish());
+    builder.add_child(ordered_list::builder(block_id())
+                          .add_item(list_item::build(par("another list")))
+                          .finish());
+    builder.add_child(par("after lists"));
+    auto doc = builder.finish();
+
+    auto cmark_ordered = build_list(CMARK_ORDERED_LIST, {});
+    for (auto i = 0; i != 10; ++i)
+        cmark_node_append_child(cmark_ordered, cmark_item("item"));
+
+    check_output(*doc,
+                 build_node(CMARK_NODE_DOCUMENT,
+                            {build_list(CMARK_BULLET_LIST,
+                                        {build_node(CMARK_NODE_ITEM,
+                                                    {build_node(CMARK_NODE_PARAGRAPH,
+                                                                {build_text("outer")}),
+                                                     build_list(CMARK_BULLET_LIST,
+                                                                {cmark_item("inner"),
+                                                                 cmark_item("- inner")})}),
+                                         build_node(CMARK_NODE_ITEM,
+                                                    {build_code_block("", "first in item\n")}),
+                                         build_node(CMARK_NODE_ITEM,
+                                                    {build_node(CMARK_NODE_PARAGRAPH,
+                                                                {build_text("term"),
+                                                                 build_text(" - "),
+                                                                 build_text("desc")})})}),
+                             build_code_block("", "after list\n"), cmark_ordered,
+                             build_list(CMARK_ORDERED_LIST, {cmark_item("another list")}),
+                             build_node(CMARK_NODE_PARAGRAPH, {build_text("after lists")})}));
+}
+
+TEST_CASE("markdown_generator documentation", "[markup]")
+{
+    cppast::cpp_file::builder      file("foo");
+    cppast::cpp_namespace::builder entity("foo", false, false);
+
+    auto par = [](const char* str) {
+        return paragraph::builder().add_child(text::build(str)).finish();
+    };
+
+    entity_documentation::builder c(type_safe::ref(entity.get()), block_id("c"),
+                                    documentation_header(heading::build(block_id(), "Entity C")),
+                                    code_block::build(block_id(), "cpp", "void c();\n"));
+    c.add_brief(brief_section::builder().add_child(text::build("Brief c.")).finish());
+
+    entity_documentation::builder b(type_safe::ref(entity.get()), block_id("b"),
+                                    documentation_header(heading::build(block_id(), "Entity B"),
+                                                         "module"),
+                                    code_block::build(block_id(), "cpp", "void b();\n"));
+    b.add_section(inline_section::builder(section_type::requires, "Requires")
+                      .add_child(code::build("b"))
+                      .add_child(text::build(" > 0"))
+                      .finish());
+    b.add_child(c.finish());
+
+    file_documentation::builder a(type_safe::ref(file.get()), block_id("a"),
+                                  documentation_header(heading::build(block_id(), "A file")),
+                                  code_block::build(block_id(), "cpp", "void b();\nvoid c();\n"));
+    a.add_brief(brief_section::builder().add_child(text::build("The brief.")).finish());
+    a.add_section(inline_section::builder(section_type::effects, "Effects")
+                      .add_child(text::build("Does *nothing*."))
+                      .finish());
+    a.add_section(inline_section::builder(section_type::notes, "Notes")
+                      .add_child(emphasis::build("Some"))
+                      .add_child(text::build(" notes."))
+                      .finish());
+    a.add_details(
+        details_section::builder().add_child(par("Details.")).add_child(par("More.")).finish());
+    a.add_section(list_section::build(
+        section_type::returns, "Return values",
+        unordered_list::builder(block_id())
+            .add_item(list_item::build(par("0")))
+            .add_item(term_description_item::build(block_id(), term::build(text::build("1")),
+                                                   description::build(text::build("one"))))
+            .finish()));
+    a.add_section(
+        list_section::build(section_type::throws, "Throws",
+                            unordered_list::builder(block_id())
+                                .add_item(list_item::build(par("nothing")))
+                                .finish()));
+    a.add_child(b.finish());
+    auto doc = a.finish();
+
+    auto build_inline_section = [](const char* name, std::initializer_list<cmark_node*> children) {
+        auto node = build_node(CMARK_NODE_PARAGRAPH,
+                               {build_node(CMARK_NODE_EMPH, {build_text(name)}), build_text(" ")});
+        for (auto child : children)
+            cmark_node_append_child(node, child);
+        return node;
+    };
+    auto build_list_section = [](std::initializer_list<cmark_node*> items) {
+        auto node = build_list(CMARK_BULLET_LIST, items);
+        cmark_node_set_list_tight(node, 1);
+        return node;
+    };
+    auto expected = [&](bool use_html) {
+        return build_node(
+            CMARK_NODE_DOCUMENT,
+            {build_heading(1, {build_text("A file")}), build_anchor(use_html, "a"),
+             build_synopsis(use_html, "void b();\nvoid c();\n"), build_paragraph("The brief."),
+             build_inline_section("Effects:", {build_text("Does *nothing*.")}),
+             build_inline_section("Notes:", {build_node(CMARK_NODE_EMPH, {build_text("Some")}),
+                                             build_text(" notes.")}),
+             build_paragraph("Details."), build_paragraph("More."),
+             build_heading(4, {build_text("Return values")}),
+             build_list_section(
+                 {build_node(CMARK_NODE_ITEM, {build_paragraph("0")}),
+                  build_node(CMARK_NODE_ITEM, {build_term(use_html, "1", "one")})}),
+             build_heading(4, {build_text("Throws")}),
+             build_list_section({build_node(CMARK_NODE_ITEM, {build_paragraph("nothing")})}),
+             build_heading(2, {build_text("Entity B"), build_text(" [module]")}),
+             build_anchor(use_html, "b"), build_synopsis(use_html, "void b();\n"),
+             build_inline_section("Requires:",
+                                  {build_literal(CMARK_NODE_CODE, "b"), build_text(" > 0")}),
+             build_heading(3, {build_text("Entity C")}), build_anchor(use_html, "c"),
+             build_synopsis(use_html, "void c();\n"), build_paragraph("Brief c."),
+             build_node(CMARK_NODE_THEMATIC_BREAK), build_node(CMARK_NODE_THEMATIC_BREAK)});
+    };
+    check_output(*doc, expected(false));
+    check_output(*doc, expected(true), true);
+}
+
+TEST_CASE("markdown_generator index", "[markup]")
+{
+    cppast::cpp_namespace::builder ns("foo", false, false);
+
+    namespace_documentation::builder ns2(type_safe::ref(ns.get()), block_id("ns2"),
+                                         heading::build(block_id(), "Namespace ns2"));
+    ns2.add_child(entity_index_item::build(block_id("b"), term::build(text::build("b"))));
+
+    namespace_documentation::builder ns1(type_safe::ref(ns.get()), block_id("ns1"),
+                                         documentation_header(heading::build(block_id(),
+                                                                             "Namespace ns1"),
+                                                              "module"));
+    ns1.add_brief(brief_section::builder().add_child(text::build("Brief ns1.")).finish());
+    ns1.add_details(details_section::builder()
+                        .add_child(paragraph::builder().add_child(text::build("Details.")).finish())
+                        .finish());
+    ns1.add_child(entity_index_item::build(block_id("a"), term::build(text::build("a")),
+                                           description::build(text::build("Brief a."))));
+    ns1.add_child(ns2.finish());
+
+    entity_index::builder entities(heading::build(block_id(), "Entity index"));
+    entities.add_child(ns1.finish());
+    entities.add_child(entity_index_item::build(block_id("c"), term::build(text::build("c")),
+                                                description::build(text::build("Brief c."))));
+    auto entity_idx = entities.finish();
+
+    auto expected_entities = [](bool use_html) {
+        auto ns2 = build_node(CMARK_NODE_ITEM,
+                              {build_heading(3, {build_text("Namespace ns2")}),
+                               build_anchor(use_html, "ns2"),
+                               build_list(CMARK_BULLET_LIST,
+                                          {build_node(CMARK_NODE_ITEM,
+                                                      {build_term(use_html, "b", nullptr)})})});
+        auto ns1
+            = build_node(CMARK_NODE_ITEM,
+                         {build_heading(2, {build_text("Namespace ns1"), build_text(" [module]")}),
+                          build_anchor(use_html, "ns1"), build_paragraph("Brief ns1."),
+                          build_paragraph("Details."),
+                          build_list(CMARK_BULLET_LIST,
+                                     {build_node(CMARK_NODE_ITEM,
+                                                 {build_term(use_html, "a", "Brief a.")}),
+                                      ns2})});
+        return build_node(
+            CMARK_NODE_DOCUMENT,
+            {build_heading(1, {build_text("Entity index")}),
+             build_list(CMARK_BULLET_LIST,
+                        {ns1, build_node(CMARK_NODE_ITEM,
+                                         {build_term(use_html, "c", "Brief c.")})})});
+    };
+    check_output(*entity_idx, expected_entities(false));
+    check_output(*entity_idx, expected_entities(true), true);
+
+    module_documentation::builder module1(block_id("module1"),
+                                          heading::build(block_id(), "Module 1"));
+    module1.add_brief(brief_section::builder().add_child(text::build("Brief.")).finish());
+    module1.add_child(entity_index_item::build(block_id("a"), term::build(text::build("a"))));
+
+    module_index::builder modules(heading::build(block_id(), "Module index"));
+    modules.add_child(module1.finish());
+    auto module_idx = modules.finish();
+
+    auto expected_modules = [](bool use_html) {
+        return build_node(
+            CMARK_NODE_DOCUMENT,
+            {build_heading(1, {build_text("Module index")}),
+             build_list(CMARK_BULLET_LIST,
+                        {build_node(CMARK_NODE_ITEM,
+                                    {build_heading(2, {build_text("Module 1")}),
+                                     build_anchor(use_html, "module1"), build_paragraph("Brief."),
+                                     build_list(CMARK_BULLET_LIST,
+                                                {build_node(CMARK_NODE_ITEM,
+                                                            {build_term(use_html, "a",
+                                                                        nullptr)})})})})});
+    };
+    check_output(*module_idx, expected_modules(false));
+    check_output(*module_idx, expected_modules(true), true);
+}
@@ -0,0 +1,101 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "glob.hpp"
+
+#include <catch.hpp>
+
+using namespace standardese_tool;
+
+TEST_CASE("glob_match", "[tool]")
+{
+    using detail::glob_match;
+
+    SECTION("no wildcard")
+    {
+        REQUIRE(glob_match("", ""));
+        REQUIRE(glob_match("a/b.hpp", "a/b.hpp"));
+        REQUIRE(!glob_match("a/b.hpp", "a/b.hp"));
+        REQUIRE(!glob_match("a/b.hp", "a/b.hpp"));
+        REQUIRE(!glob_match("", "a"));
+    }
+    SECTION("?")
+    {
+        REQUIRE(glob_match("?.hpp", "a.hpp"));
+        REQUIRE(glob_match("a?b", "axb"));
+        REQUIRE(!glob_match("?.hpp", ".hpp"));
+        REQUIRE(!glob_match("a?b", "a/b"));
+    }
+    SECTION("*")
+    {
+        REQUIRE(glob_match("*", ""));
+        REQUIRE(glob_match("*", "abc"));
+        REQUIRE(glob_match("*.hpp", ".hpp"));
+        REQUIRE(glob_match("*.hpp", "a.b.hpp"));
+        REQUIRE(glob_match("a*b*c", "abbbc"));
+        REQUIRE(glob_match("a*b*c", "aXbYbZc"));
+        REQUIRE(glob_match("detail/*", "detail/a.hpp"));
+        REQUIRE(glob_match("*/*", "a/b"));
+        REQUIRE(!glob_match("*", "a/b"));
+        REQUIRE(!glob_match("*.hpp", "a/b.hpp"));
+        REQUIRE(!glob_match("a*b*c", "abcb"));
+        REQUIRE(!glob_match("*/*", "a/b/c"));
+        REQUIRE(!glob_match("a*/b", "a/x/b"));
+    }
+    SECTION("**")
+    {
+        REQUIRE(glob_match("**", ""));
+        REQUIRE(glob_match("**", "a/b/c"));
+        REQUIRE(glob_match("a/**", "a/b/c"));
+        REQUIRE(glob_match("a**c", "a/b/c"));
+        REQUIRE(glob_match("**.hpp", "a/b.hpp"));
+        REQUIRE(glob_match("**/detail/*", "a/b/detail/c.hpp"));
+        REQUIRE(glob_match("**/*.hpp", "a/b/c.hpp"));
+        REQUIRE(glob_match("a/**/*/c", "a/x/y/c"));
+        REQUIRE(!glob_match("a/**", "b/c"));
+        REQUIRE(!glob_match("**/detail/*", "a/detail/b/c.hpp"));
+        REQUIRE(!glob_match("**/*.hpp", "a/b/c.cpp"));
+    }
+    SECTION("**/ matches zero directories")
+    {
+        REQUIRE(glob_match("**/x", "x"));
+        REQUIRE(glob_match("**/*.hpp", "a.hpp"));
+        REQUIRE(glob_match("a/**/b", "a/b"));
+        REQUIRE(glob_match("a/**/b", "a/x/y/b"));
+        REQUIRE(!glob_match("**/x", "ax"));
+        REQUIRE(!glob_match("a/**/b", "a/xb"));
+        // only at the start of a segment
+        REQUIRE(glob_match("a**/b", "ax/y/b"));
+        REQUIRE(!glob_match("a**/b", "ab"));
+    }
+    SECTION("many wildcards")
+    {
+        // would take exponential time with naive recursion
+        std::string pattern, str(64, 'a');
+        for (auto i = 0; i != 16; ++i)
+            pattern += "*a";
+        REQUIRE(!glob_match((pattern + "b").c_str(), str.c_str()));
+        REQUIRE(glob_match(pattern.c_str(), str.c_str()));
+
+        pattern.clear();
+        for (auto i = 0; i != 16; ++i)
+            pattern += "**a";
+        REQUIRE(!glob_match((pattern + "b").c_str(), (str + "/a").c_str()));
+        REQUIRE(glob_match(pattern.c_str(), (str + "/a").c_str()));
+    }
+}
+
+TEST_CASE("name_matcher", "[tool]")
+{
+    name_matcher matcher({"a.hpp", "detail/*", "**/impl"});
+    REQUIRE(matcher.matches("a.hpp"));
+    REQUIRE(matcher.matches("detail/b.hpp"));
+    REQUIRE(matcher.matches("impl"));
+    REQUIRE(matcher.matches("x/y/impl"));
+    REQUIRE(!matcher.matches("b.hpp"));
+    REQUIRE(!matcher.matches("detail/x/b.hpp"));
+    REQUIRE(!matcher.matches("x/implementation"));
+
+    REQUIRE(!name_matcher().matches(""));
+}
@@ -0,0 +1,288 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "executor.hpp"
+
+#include <algorithm>
+#include <exception>
+
+using namespace standardese_tool;
+
+namespace
+{
+struct current_worker
+{
+    const executor* exec;
+    unsigned        index;
+};
+
+thread_local current_worker current = {nullptr, 0u};
+
+using steady_clock = std::chrono::steady_clock;
+
+std::int64_t elapsed_ns(steady_clock::time_point start)
+{
+    auto elapsed = steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+// the state of one parallel_for() invocation
+class loop
+{
+public:
+    loop(std::vector<std::uint64_t> costs, const std::function<void(std::size_t)>& f,
+         unsigned no_threads)
+    : order_(costs.size()), prefix_(costs.size() + 1u), f_(f), next_(0u), completed_(0u),
+      // so the last chunks are small enough to be balanced
+      divisor_(2u * no_threads)
+    {
+        for (auto i = std::size_t(0); i != order_.size(); ++i)
+            order_[i] = i;
+        // stable, so equally expensive ones are started in order
+        std::stable_sort(order_.begin(), order_.end(),
+                         [&](std::size_t a, std::size_t b) { return costs[a] > costs[b]; });
+
+        prefix_[0] = 0u;
+        for (auto i = std::size_t(0); i != order_.size(); ++i)
+            prefix_[i + 1u] = prefix_[i] + std::max(costs[order_[i]], std::uint64_t(1u));
+    }
+
+    std::size_t size() const noexcept
+    {
+        return order_.size();
+    }
+
+    bool is_finished() const noexcept
+    {
+        return completed_ == order_.size();
+    }
+
+    // runs chunks until there are none left
+    // returns whether or not it finished the loop
+    bool drain()
+    {
+        std::size_t begin, end;
+        while (claim(begin, end))
+        {
+            for (auto i = begin; i != end; ++i)
+                if (!has_exception_)
+                    try
+                    {
+                        f_(order_[i]);
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex_);
+                        if (!exception_)
+                            exception_ = std::current_exception();
+                        has_exception_ = true;
+                    }
+
+            if (completed_.fetch_add(end - begin) + (end - begin) == order_.size())
+                return true;
+        }
+        return false;
+    }
+
+    void rethrow()
+    {
+        if (exception_)
+            std::rethrow_exception(exception_);
+    }
+
+private:
+    // claims the next chunk of indices
+    // a chunk is a fraction of the remaining cost,
+    // so expensive indices are claimed alone and cheap ones in bulk
+    bool claim(std::size_t& begin, std::size_t& end)
+    {
+        auto cur = next_.load();
+        do
+        {
+            if (cur == order_.size())
+                return false;
+
+            auto target = std::max((prefix_.back() - prefix_[cur]) / divisor_, std::uint64_t(1u));
+            auto last   = std::upper_bound(prefix_.begin() + std::ptrdiff_t(cur) + 1, prefix_.end(),
+                                         prefix_[cur] + target);
+            end = std::max(std::size_t(last - prefix_.begin()) - 1u, cur + 1u);
+        } while (!next_.compare_exchange_weak(cur, end));
+
+        begin = cur;
+        return true;
+    }
+
+    std::vector<std::size_t>                 order_;
+    std::vector<std::uint64_t>               prefix_; // prefix sums of the costs in order
+    const std::function<void(std::size_t)>& f_;
+
+    std::atomic<std::size_t> next_, completed_;
+    std::uint64_t            divisor_;
+
+    std::mutex         mutex_;
+    std::exception_ptr exception_;
+    std::atomic<bool>  has_exception_{false};
+};
+} // namespace
+
+executor::executor(unsigned no_threads) : pending_(0u), stop_(false)
+{
+    no_threads = std::max(no_threads, 1u);
+    for (auto i = 0u; i != no_threads; ++i)
+        workers_.emplace_back(new worker);
+
+    current = {this, 0u};
+    for (auto i = 1u; i != no_threads; ++i)
+        threads_.emplace_back([this, i] { work(i); });
+}
+
+executor::~executor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& thread : threads_)
+        thread.join();
+    current = {nullptr, 0u};
+}
+
+std::vector<executor::worker_statistics> executor::statistics() const
+{
+    std::vector<worker_statistics> result;
+    for (auto& w : workers_)
+        result.push_back({std::chrono::nanoseconds(w->busy_ns.load()),
+                          std::chrono::nanoseconds(w->idle_ns.load()), w->no_tasks.load(),
+                          w->no_steals.load()});
+    return result;
+}
+
+void executor::do_parallel_for(std::vector<std::uint64_t>              costs,
+                               const std::function<void(std::size_t)>& f)
+{
+    if (costs.empty())
+        return;
+
+    auto state = std::make_shared<loop>(std::move(costs), f, no_threads());
+    auto drain = [this, state] {
+        if (state->drain())
+        {
+            // wake up the thread waiting for it
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_all();
+        }
+    };
+
+    // one task per other worker, they finish as soon as no chunk is left
+    auto self       = current_index();
+    auto no_helpers = std::min(std::size_t(no_threads() - 1u), state->size() - 1u);
+    for (auto i = 1u; i <= no_helpers; ++i)
+        push((self + i) % no_threads(), drain);
+
+    auto start = steady_clock::now();
+    state->drain();
+    workers_[self]->busy_ns += elapsed_ns(start);
+
+    // help with other tasks until the remaining chunks are finished
+    while (!state->is_finished())
+    {
+        task t;
+        if (pop_or_steal(self, t))
+            run(self, t);
+        else
+        {
+            auto                         start = steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] { return state->is_finished() || pending_ > 0u; });
+            workers_[self]->idle_ns += elapsed_ns(start);
+        }
+    }
+
+    state->rethrow();
+}
+
+void executor::push(unsigned index, task t)
+{
+    {
+        std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+        workers_[index]->tasks.push_back(std::move(t));
+    }
+
+    {
+        // under the lock, so a worker can't miss it
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++pending_;
+    }
+    cv_.notify_all();
+}
+
+bool executor::pop_or_steal(unsigned index, task& t)
+{
+    {
+        // own tasks are taken from the back, they're still hot
+        auto&                       w = *workers_[index];
+        std::lock_guard<std::mutex> lock(w.mutex);
+        if (!w.tasks.empty())
+        {
+            t = std::move(w.tasks.back());
+            w.tasks.pop_back();
+            --pending_;
+            return true;
+        }
+    }
+
+    for (auto i = 1u; i != no_threads(); ++i)
+    {
+        // other tasks are stolen from the front
+        auto&                       victim = *workers_[(index + i) % no_threads()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            t = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            --pending_;
+            ++workers_[index]->no_steals;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void executor::run(unsigned index, const task& t)
+{
+    auto start = steady_clock::now();
+    t();
+    workers_[index]->busy_ns += elapsed_ns(start);
+    ++workers_[index]->no_tasks;
+}
+
+unsigned executor::current_index() const noexcept
+{
+    return current.exec == this ? current.index : 0u;
+}
+
+void executor::work(unsigned index)
+{
+    current = {this, index};
+
+    while (true)
+    {
+        task t;
+        if (pop_or_steal(index, t))
+            run(index, t);
+        else
+        {
+            auto                         start = steady_clock::now();
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [&] { return stop_ || pending_ > 0u; });
+            workers_[index]->idle_ns += elapsed_ns(start);
+
+            if (stop_ && pending_ == 0u)
+                break;
+        }
+    }
+}
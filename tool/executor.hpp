@@ -0,0 +1,116 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_EXECUTOR_HPP_INCLUDED
+#define STANDARDESE_TOOL_EXECUTOR_HPP_INCLUDED
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace standardese_tool
+{
+inline unsigned default_no_threads()
+{
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+// a work stealing executor shared by all phases of a run
+//
+// Each worker has its own queue of tasks, an idle worker steals from the others.
+// The thread creating the executor is the first worker and helps while it waits.
+class executor
+{
+public:
+    struct worker_statistics
+    {
+        std::chrono::nanoseconds busy, idle;
+        std::uint64_t            tasks, steals;
+    };
+
+    // starts `no_threads - 1` additional threads
+    explicit executor(unsigned no_threads);
+
+    executor(const executor&) = delete;
+    executor& operator=(const executor&) = delete;
+
+    // waits for all threads to finish
+    ~executor();
+
+    unsigned no_threads() const noexcept
+    {
+        return static_cast<unsigned>(workers_.size());
+    }
+
+    // invokes `f(i)` for all `i` in `[0, n)` and waits for them to finish
+    // the indices are started in descending order of `cost(i)`,
+    // so an expensive one doesn't start last and delays everything,
+    // cheap ones are grouped together to reduce the scheduling overhead
+    // if `f` throws, the remaining indices are skipped and the first exception is rethrown
+    // must be called from the thread that created the executor or from inside a task
+    template <typename Fnc, typename Cost>
+    void parallel_for(std::size_t n, Fnc f, Cost cost)
+    {
+        std::vector<std::uint64_t> costs;
+        costs.reserve(n);
+        for (auto i = std::size_t(0); i != n; ++i)
+            costs.push_back(cost(i));
+        do_parallel_for(std::move(costs), f);
+    }
+
+    // same as above, but all indices are equally expensive
+    template <typename Fnc>
+    void parallel_for(std::size_t n, Fnc f)
+    {
+        do_parallel_for(std::vector<std::uint64_t>(n, 1u), f);
+    }
+
+    // returns the statistics of each worker, the first one is the creating thread
+    // the idle time can be used to tune the number of threads
+    std::vector<worker_statistics> statistics() const;
+
+private:
+    using task = std::function<void()>;
+
+    struct worker
+    {
+        std::mutex       mutex;
+        std::deque<task> tasks;
+
+        std::atomic<std::int64_t>  busy_ns, idle_ns;
+        std::atomic<std::uint64_t> no_tasks, no_steals;
+
+        worker() : busy_ns(0), idle_ns(0), no_tasks(0u), no_steals(0u) {}
+    };
+
+    void do_parallel_for(std::vector<std::uint64_t> costs,
+                         const std::function<void(std::size_t)>& f);
+
+    void     push(unsigned index, task t);
+    bool     pop_or_steal(unsigned index, task& t);
+    void     run(unsigned index, const task& t);
+    unsigned current_index() const noexcept;
+
+    void work(unsigned index);
+
+    std::vector<std::unique_ptr<worker>> workers_;
+    std::vector<std::thread>             threads_;
+
+    // protects sleeping
+    std::mutex               mutex_;
+    std::condition_variable  cv_;
+    std::atomic<std::size_t> pending_; // number of queued tasks
+    bool                     stop_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_EXECUTOR_HPP_INCLUDED
@@ -5,11 +5,16 @@
 #ifndef STANDARDESE_FILESYSTEM_HPP_INCLUDED
 #define STANDARDESE_FILESYSTEM_HPP_INCLUDED
 
+#include <algorithm>
+#include <iterator>
 #include <string>
 #include <vector>
 
 #include <boost/filesystem.hpp>
 
+#include "executor.hpp"
+#include "glob.hpp"
+
 namespace standardese_tool
 {
 namespace fs = boost::filesystem;
@@ -18,101 +23,150 @@ namespace fs = boost::filesystem;
 using blacklist = std::vector<std::string>;
 using whitelist = blacklist;
 
-namespace detail
+// the compiled input options
+class input_filter
 {
-    inline fs::path get_relative_path(const fs::path& path, const fs::path& root)
+public:
+    // the files and directories are relative paths,
+    // an extension of `.` matches files without extension
+    input_filter(const whitelist& source_extensions, const blacklist& extensions,
+                 const blacklist& files, const blacklist& dirs, bool blacklist_dotfiles)
+    : source_extensions_(source_extensions),
+      extensions_(extensions),
+      files_(normalize(files)),
+      dirs_(normalize(dirs)),
+      blacklist_dotfiles_(blacklist_dotfiles)
+    {}
+
+    // is_directory is passed in, so the caller can use the type of the directory entry
+    bool is_valid(const fs::path& path, const fs::path& relative, bool is_directory) const
     {
-#if BOOST_VERSION / 100 % 1000 < 60
-        auto relative = path.c_str() + root.native().size();
-        if (*relative == '/' || *relative == '\\')
-            ++relative;
-        return relative;
-#else
-        return fs::relative(path, root);
-#endif
+        if (blacklist_dotfiles_ && path.filename().generic_string()[0] == '.')
+            return false;
+        else if (is_directory)
+            return !dirs_.matches(relative.generic_string());
+        else if (!relative.empty() && files_.matches(relative.generic_string()))
+            return false;
+
+        auto ext = path.extension().generic_string();
+        return !extensions_.matches(ext.empty() ? "." : ext);
     }
 
-    inline bool is_valid(const fs::path& path, const fs::path& relative,
-                         const blacklist& extensions, const blacklist& files, const blacklist& dirs,
-                         bool blacklist_dotfiles)
+    bool is_source_file(const fs::path& path) const
     {
-        if (blacklist_dotfiles && path.filename().generic_string()[0] == '.')
-            return false;
+        return source_extensions_.matches(path.extension().generic_string());
+    }
 
-        if (fs::is_directory(path))
-        {
-            for (auto& d : dirs)
-                if (relative == d)
-                    return false;
-        }
-        else
+private:
+    static std::vector<std::string> normalize(const std::vector<std::string>& paths)
+    {
+        std::vector<std::string> result;
+        for (auto& path : paths)
         {
-            for (auto& f : files)
-                if (relative == f)
-                    return false;
-
-            auto ext = path.extension();
-            for (auto& e : extensions)
-                if (ext == e || (ext.empty() && e == "."))
-                    return false;
+            // remove trailing slash if any, and use the same separators as the relative paths
+            auto normalized = fs::path(path).generic_string();
+            while (normalized.size() > 1u && normalized.back() == '/')
+                normalized.pop_back();
+            result.push_back(std::move(normalized));
         }
-
-        return true;
+        return result;
     }
 
-    inline bool is_source_file(const fs::path& path, const whitelist& source_extensions)
-    {
-        auto ext = path.extension();
-        for (auto& e : source_extensions)
-            if (ext == e)
-                return true;
-        return false;
-    }
-} // namespace detail
+    name_matcher source_extensions_, extensions_, files_, dirs_;
+    bool         blacklist_dotfiles_;
+};
 
-// a path is determined valid through the blacklists
-// if given path is normal file and valid, calls f for it
-// otherwise recursively traverses through the given directory and calls f for each valid file
-// returns false if path was a normal file that was marked as invalid, true otherwise
-template <typename Fun>
-bool handle_path(const fs::path& path, const whitelist& source_extensions,
-                 const blacklist& extensions, const blacklist& files, blacklist dirs,
-                 bool blacklist_dotfiles, bool force_blacklist, Fun f)
+namespace detail
 {
-    // remove trailing slash if any
-    // otherwise Boost.Filesystem can't handle it
-    for (auto& dir : dirs)
+    struct scanned_file
     {
-        if (dir.back() == '/' || dir.back() == '\\')
-            dir.pop_back();
-    }
+        fs::path path, relative;
+        bool     is_source;
+    };
 
-    if (fs::is_directory(path))
+    struct scanned_path
     {
-        auto end = fs::recursive_directory_iterator();
-        for (auto iter = fs::recursive_directory_iterator(path); iter != end; ++iter)
+        fs::path path, relative;
+    };
+
+    // scans the directories level by level, the directories of a level in parallel
+    // the type of an entry is taken from the directory itself where possible,
+    // so only symlinks need an additional stat,
+    // and the relative path is the relative path of the parent plus the filename
+    // the files are returned in a deterministic order:
+    // level by level, and sorted by name inside each directory
+    inline std::vector<scanned_file> scan_directory(const fs::path&     root,
+                                                    const input_filter& filter, executor& exec)
+    {
+        struct scanned_directory
         {
-            auto& cur      = iter->path();
-            auto  relative = detail::get_relative_path(cur, path);
+            std::vector<scanned_file> files;
+            std::vector<scanned_path> directories;
+        };
 
-            if (fs::is_directory(cur))
-            {
-                if (!detail::is_valid(cur, relative, extensions, files, dirs, blacklist_dotfiles))
-                    iter.no_push();
-            }
-            else if (detail::is_valid(cur, relative, extensions, files, dirs, blacklist_dotfiles))
+        std::vector<scanned_file> result;
+        std::vector<scanned_path> level = {{root, fs::path()}};
+        while (!level.empty())
+        {
+            std::vector<scanned_directory> scanned(level.size());
+            exec.parallel_for(level.size(), [&](std::size_t i) {
+                std::vector<fs::directory_entry> entries(fs::directory_iterator(level[i].path),
+                                                         fs::directory_iterator());
+                std::sort(entries.begin(), entries.end(),
+                          [](const fs::directory_entry& a, const fs::directory_entry& b) {
+                              return a.path().filename() < b.path().filename();
+                          });
+
+                for (auto& entry : entries)
+                {
+                    auto& cur          = entry.path();
+                    auto  relative     = level[i].relative / cur.filename();
+                    auto  is_directory = fs::is_directory(entry.status());
+                    if (!filter.is_valid(cur, relative, is_directory))
+                        // pruned before descending
+                        continue;
+                    else if (!is_directory)
+                        scanned[i].files.push_back(
+                            {cur, std::move(relative), filter.is_source_file(cur)});
+                    else if (!fs::is_symlink(entry.symlink_status()))
+                        // like recursive_directory_iterator, don't follow symlinks
+                        scanned[i].directories.push_back({cur, std::move(relative)});
+                }
+            });
+
+            level.clear();
+            for (auto& dir : scanned)
             {
-                f(detail::is_source_file(cur, source_extensions), cur, relative);
+                std::move(dir.files.begin(), dir.files.end(), std::back_inserter(result));
+                std::move(dir.directories.begin(), dir.directories.end(),
+                          std::back_inserter(level));
             }
         }
+
+        return result;
+    }
+} // namespace detail
+
+// a path is determined valid through the blacklists
+// if given path is normal file and valid, calls f for it
+// otherwise traverses through the given directory in parallel and calls f for each valid file
+// returns false if path was a normal file that was marked as invalid, true otherwise
+template <typename Fun>
+bool handle_path(const fs::path& path, const input_filter& filter, bool force_blacklist,
+                 executor& exec, Fun f)
+{
+    auto status = fs::status(path);
+    if (fs::is_directory(status))
+    {
+        for (auto& file : detail::scan_directory(path, filter, exec))
+            f(file.is_source, file.path, file.relative);
     }
-    else if (!fs::exists(path))
+    else if (!fs::exists(status))
         throw std::runtime_error("file '" + path.generic_string() + "' does not exist");
-    else if (!force_blacklist
-             || detail::is_valid(path, "", extensions, files, dirs, blacklist_dotfiles))
+    else if (!force_blacklist || filter.is_valid(path, "", false))
     {
         // return only the filename of the path as relative path
-        f(detail::is_source_file(path, source_extensions), path, path.filename());
+        f(filter.is_source_file(path), path, path.filename());
     }
     else
         return false;
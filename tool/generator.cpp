@@ -4,12 +4,14 @@
 
 #include "generator.hpp"
 
-#include <fstream>
+#include <atomic>
 
 #include <standardese/index.hpp>
 #include <standardese/linker.hpp>
 
-#include "thread_pool.hpp"
+#include "executor.hpp"
+#include "logger.hpp"
+#include "trace.hpp"
 
 using namespace standardese_tool;
 
@@ -17,35 +19,55 @@ type_safe::optional<std::vector<parsed_file>> standardese_tool::parse(
     const cppast::libclang_compile_config&                            config,
     const type_safe::optional<cppast::libclang_compilation_database>& database,
     const std::vector<input_file>& files, const cppast::cpp_entity_index& index,
-    unsigned no_threads)
+    const standardese::file_comment_parser& comment_parser, executor& exec)
 {
-    std::vector<parsed_file> result;
-    bool                     error(false);
-    cppast::libclang_parser  parser(cppast::default_logger());
+    // the results are stored in order of the input files, independent of the scheduling
+    std::vector<parsed_file>       result(files.size());
+    std::vector<diagnostic_buffer> diagnostics(files.size());
+    cppast::libclang_parser        parser(diagnostic_buffer::logger());
+
+    exec.parallel_for(
+        files.size(),
+        [&](std::size_t i) {
+            diagnostic_buffer::capture capture(diagnostics[i]);
+
+            auto& file      = files[i];
+            auto  db_config = database.map([&](const cppast::libclang_compilation_database& db) {
+                return cppast::find_config_for(db, file.path.generic_string());
+            });
+
+            auto actual_config = db_config.value_or(config);
+            actual_config.fast_preprocessing(
+                true); // we can uncoditionally enable fast preprocessing for us
+            auto& path = file.canonical;
+
+            std::unique_ptr<cppast::cpp_file> parsed;
+            {
+                trace_scope trace("parse", path);
+                parsed = parser.parse(index, path, actual_config);
+            }
+            if (parsed)
+            {
+                // don't wait for the other files
+                trace_scope trace("parse comments", path);
+                comment_parser.parse(type_safe::ref(*parsed));
+            }
+
+            result[i] = {std::move(parsed), file.relative.generic_string()};
+        },
+        [&](std::size_t i) {
+            // bigger files take longer to parse, start them first
+            boost::system::error_code ec;
+            auto                      size = fs::file_size(files[i].path, ec);
+            return ec ? 0u : std::uint64_t(size);
+        });
 
+    auto error = false;
+    for (auto i = std::size_t(0); i != files.size(); ++i)
     {
-        std::mutex  mutex;
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-        {
-            add_job(pool, [&, file] {
-                auto db_config = database.map([&](const cppast::libclang_compilation_database& db) {
-                    return cppast::find_config_for(db, file.path.generic_string());
-                });
-
-                auto actual_config = db_config.value_or(config);
-                actual_config.fast_preprocessing(
-                    true); // we can uncoditionally enable fast preprocessing for us
-                auto parsed
-                    = parser.parse(index, fs::canonical(file.path).generic_string(), actual_config);
-
-                std::lock_guard<std::mutex> lock(mutex);
-                if (parsed)
-                    result.push_back({std::move(parsed), file.relative.generic_string()});
-                else
-                    error = true;
-            });
-        }
+        diagnostics[i].replay();
+        if (!result[i].file)
+            error = true;
     }
 
     if (error)
@@ -54,46 +76,25 @@ type_safe::optional<std::vector<parsed_file>> standardese_tool::parse(
         return std::move(result);
 }
 
-standardese::comment_registry standardese_tool::parse_comments(
-    const standardese::comment::config& config, const std::vector<parsed_file>& files,
-    unsigned no_threads)
-{
-    standardese::file_comment_parser parser(cppast::default_logger(), config);
-    {
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-            add_job(pool, [&file, &parser] { parser.parse(type_safe::ref(*file.file)); });
-    }
-    return parser.finish();
-}
-
 std::vector<std::unique_ptr<standardese::doc_cpp_file>> standardese_tool::build_files(
     const standardese::comment_registry& registry, const cppast::cpp_entity_index& index,
     std::vector<parsed_file>&& files, const standardese::entity_blacklist& blacklist,
-    unsigned no_threads)
+    executor& exec)
 {
-    {
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-            add_job(pool,
-                    [&] { standardese::exclude_entities(registry, index, blacklist, *file.file); });
-    }
-
-    std::vector<std::unique_ptr<standardese::doc_cpp_file>> result;
-
-    {
-        std::mutex  mutex;
-        thread_pool pool(no_threads);
-        for (auto& file : files)
-            add_job(pool, [&] {
-                auto entity = standardese::build_doc_entities(type_safe::ref(registry), index,
-                                                              std::move(file.file),
-                                                              std::move(file.output_name));
-
-                std::lock_guard<std::mutex> lock(mutex);
-                result.push_back(std::move(entity));
-            });
-    }
+    exec.parallel_for(files.size(), [&](std::size_t i) {
+        trace_scope trace("exclude_entities", files[i].output_name);
+        standardese::exclude_entities(registry, index, blacklist, *files[i].file);
+    });
+
+    std::vector<std::unique_ptr<standardese::doc_cpp_file>> result(files.size());
+    exec.parallel_for(files.size(), [&](std::size_t i) {
+        trace_scope trace("build_doc_entities", files[i].output_name);
+        // the entities are freed together with the AST
+        standardese::markup::entity_arena arena;
+        result[i] = standardese::build_doc_entities(type_safe::ref(registry), index,
+                                                    std::move(files[i].file),
+                                                    std::move(files[i].output_name));
+    });
 
     return result;
 }
@@ -112,72 +113,125 @@ std::unique_ptr<standardese::markup::document_entity> get_index_document(
 documents standardese_tool::generate(
     const standardese::generation_config& gen_config,
     const standardese::synopsis_config& syn_config, const standardese::comment_registry& comments,
-    const cppast::cpp_entity_index& index, const standardese::linker& linker,
-    const std::vector<std::unique_ptr<standardese::doc_cpp_file>>& files, unsigned no_threads)
+    const cppast::cpp_entity_index& index, standardese::linker& linker,
+    std::vector<std::unique_ptr<standardese::doc_cpp_file>>&& files, executor& exec)
 {
-    std::mutex                                                         result_mutex;
-    std::vector<std::unique_ptr<standardese::markup::document_entity>> result;
-
+    std::vector<std::unique_ptr<standardese::markup::document_entity>> result(files.size());
+    exec.parallel_for(files.size(), [&](std::size_t i) {
+        auto&       file = files[i];
+        trace_scope trace("generate_documentation", file->output_name());
+        // the entities are freed together with the document
+        standardese::markup::entity_arena arena;
+
+        standardese::markup::subdocument::builder document(
+            file->output_name(), "doc_" + get_output_file_name(file->output_name()));
+        document.add_child(
+            standardese::generate_documentation(gen_config, syn_config, index, *file));
+        result[i] = document.finish();
+    });
+
+    // register in order of the input files, so the indices and the diagnostics about duplicate
+    // links are independent of the scheduling
     standardese::entity_index eindex;
     standardese::file_index   findex;
     standardese::module_index mindex;
-
+    for (auto i = std::size_t(0); i != files.size(); ++i)
     {
-        thread_pool pool(no_threads);
-
-        std::vector<std::future<void>> futures;
-        for (auto& file : files)
-            futures.push_back(add_job(pool, [&] {
-                standardese::markup::subdocument::builder document(file->output_name(),
-                                                                   "doc_"
-                                                                       + get_output_file_name(
-                                                                             file->output_name()));
-                document.add_child(
-                    standardese::generate_documentation(gen_config, syn_config, index, *file));
-                auto finished_doc = document.finish();
-
-                standardese::register_documentations(*cppast::default_logger(), linker,
-                                                     *finished_doc);
-                standardese::register_index_entities(eindex, file->file());
-                standardese::register_module_entities(mindex, comments, file->file());
-                findex.register_file(file->link_name(), file->output_name(),
-                                     file->comment() ? file->comment().value().brief_section()
-                                                     : nullptr);
-
-                std::lock_guard<std::mutex> lock(result_mutex);
-                result.push_back(std::move(finished_doc));
-            }));
-
-        for (auto& future : futures)
-            future.get(); // to retrieve exceptions
+        auto&       file = files[i];
+        trace_scope trace("register_documentations", file->output_name());
+
+        standardese::register_documentations(*cppast::default_logger(), linker, *result[i]);
+        standardese::register_index_entities(eindex, file->file());
+        standardese::register_module_entities(mindex, comments, file->file());
+        findex.register_file(file->link_name(), file->output_name(),
+                             file->comment() ? file->comment().value().brief_section() : nullptr);
     }
 
-    auto eindex_doc = get_index_document(eindex.generate(gen_config.order()), "Entities",
-                                         "standardese_entities");
-    standardese::register_documentations(*cppast::default_logger(), linker, *eindex_doc);
-    result.push_back(std::move(eindex_doc));
+    {
+        trace_scope trace("register indices");
+
+        auto eindex_doc = get_index_document(eindex.generate(gen_config.order()), "Entities",
+                                             "standardese_entities");
+        standardese::register_documentations(*cppast::default_logger(), linker, *eindex_doc);
+        result.push_back(std::move(eindex_doc));
 
-    auto findex_doc = get_index_document(findex.generate(), "Files", "standardese_files");
-    standardese::register_documentations(*cppast::default_logger(), linker, *findex_doc);
-    result.push_back(std::move(findex_doc));
+        auto findex_doc = get_index_document(findex.generate(), "Files", "standardese_files");
+        standardese::register_documentations(*cppast::default_logger(), linker, *findex_doc);
+        result.push_back(std::move(findex_doc));
 
-    auto mindex_doc = get_index_document(mindex.generate(), "Modules", "standardese_modules");
-    standardese::register_documentations(*cppast::default_logger(), linker, *mindex_doc);
-    result.push_back(std::move(mindex_doc));
+        auto mindex_doc = get_index_document(mindex.generate(), "Modules", "standardese_modules");
+        standardese::register_documentations(*cppast::default_logger(), linker, *mindex_doc);
+        result.push_back(std::move(mindex_doc));
+    }
 
-    for (auto& doc : result)
-        standardese::resolve_links(*cppast::default_logger(), linker, *doc);
+    // everything is registered, lookups no longer need to lock
+    linker.freeze();
+
+    // the ASTs are no longer needed, free them before the documents are written
+    exec.parallel_for(files.size(), [&](std::size_t i) {
+        trace_scope trace("free AST");
+        files[i].reset();
+    });
+    auto files_count = files.size();
+    files.clear();
+
+    // the documents are independent, only the diagnostics need to be in order
+    std::vector<diagnostic_buffer> diagnostics(result.size());
+    exec.parallel_for(
+        result.size(),
+        [&](std::size_t i) {
+            diagnostic_buffer::capture capture(diagnostics[i]);
+            trace_scope                trace("resolve_links", result[i]->output_name().name());
+            standardese::resolve_links(*diagnostic_buffer::logger(), linker, *result[i]);
+        },
+        [&](std::size_t i) {
+            // the indices contain links to every file or entity, start them first
+            return i < files_count ? 1u : std::uint64_t(files_count);
+        });
+    for (auto& buffer : diagnostics)
+        buffer.replay();
 
     return result;
 }
 
-void standardese_tool::write_files(const documents& docs, standardese::markup::generator generator,
-                                   std::string prefix, const char* extension, unsigned no_threads)
+write_result standardese_tool::write_files(documents&&                       docs,
+                                           const std::vector<output_format>& formats,
+                                           output_manifest& manifest, executor& exec,
+                                           const document_filter& filter)
 {
-    thread_pool pool(no_threads);
-    for (auto& doc : docs)
-        add_job(pool, [&] {
-            std::ofstream file(prefix + doc->output_name().file_name(extension));
-            generator(file, *doc);
-        });
+    std::vector<std::atomic<std::uint64_t>> bytes(formats.size());
+    for (auto& b : bytes)
+        b = 0u;
+    std::atomic<std::uint64_t> written(0u), skipped(0u);
+
+    exec.parallel_for(docs.size(), [&](std::size_t i) {
+        auto& doc = *docs[i];
+        for (auto f = std::size_t(0); f != formats.size(); ++f)
+        {
+            auto& format = formats[f];
+            auto  path   = format.prefix + doc.output_name().file_name(format.extension);
+            if (filter && !filter(doc, format))
+            {
+                manifest.keep(path);
+                continue;
+            }
+
+            trace_scope                       trace("write_files", path);
+            standardese::markup::string_output out;
+            format.generator(out, doc);
+
+            auto content = out.release();
+            bytes[f] += content.size();
+            if (manifest.write(path, content))
+                ++written;
+            else
+                ++skipped;
+        }
+
+        // the links are resolved and the indices generated, nothing refers to it anymore
+        docs[i].reset();
+    });
+    docs.clear();
+
+    return {std::vector<std::uint64_t>(bytes.begin(), bytes.end()), written, skipped};
 }
@@ -5,6 +5,8 @@
 #ifndef STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
 #define STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
 
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 #include <cppast/cpp_entity_index.hpp>
@@ -17,14 +19,17 @@
 #include <standardese/markup/document.hpp>
 #include <standardese/markup/generator.hpp>
 
+#include "executor.hpp"
 #include "filesystem.hpp"
+#include "output_manifest.hpp"
 
 namespace standardese_tool
 {
 struct input_file
 {
-    fs::path path;
-    fs::path relative;
+    fs::path    path;
+    fs::path    relative;
+    std::string canonical; // generic string of the canonical path, computed once
 };
 
 struct parsed_file
@@ -33,32 +38,64 @@ struct parsed_file
     std::string                       output_name;
 };
 
+// parses the files and their comments
+// the comments of a file are parsed as soon as the file itself has been parsed,
+// call `comment_parser.finish()` afterwards to match the remote comments
 type_safe::optional<std::vector<parsed_file>> parse(
     const cppast::libclang_compile_config&                            config,
     const type_safe::optional<cppast::libclang_compilation_database>& database,
     const std::vector<input_file>& files, const cppast::cpp_entity_index& index,
-    unsigned no_threads);
-
-standardese::comment_registry parse_comments(const standardese::comment::config& config,
-                                             const std::vector<parsed_file>&     files,
-                                             unsigned                            no_threads);
+    const standardese::file_comment_parser& comment_parser, executor& exec);
 
+// excludes entities and builds the doc entities
+// all files must be excluded before any is built:
+// building looks at the excluded state of base classes and using declarations in other files
 std::vector<std::unique_ptr<standardese::doc_cpp_file>> build_files(
     const standardese::comment_registry& registry, const cppast::cpp_entity_index& index,
     std::vector<parsed_file>&& files, const standardese::entity_blacklist& blacklist,
-    unsigned no_threads);
+    executor& exec);
 
 using documents = std::vector<std::unique_ptr<standardese::markup::document_entity>>;
 
+// generates the documentation and resolves the links
+// all files must have been built:
+// the synopsis of a file refers to the doc entities of other files
+// the files are destroyed once all documentations are registered,
+// resolving the links and writing the documents only needs the markup
+// the linker is frozen after the registration
 documents generate(const standardese::generation_config& gen_config,
                    const standardese::synopsis_config&   syn_config,
                    const standardese::comment_registry&  comments,
-                   const cppast::cpp_entity_index& index, const standardese::linker& linker,
-                   const std::vector<std::unique_ptr<standardese::doc_cpp_file>>& files,
-                   unsigned                                                       no_threads);
+                   const cppast::cpp_entity_index& index, standardese::linker& linker,
+                   std::vector<std::unique_ptr<standardese::doc_cpp_file>>&& files,
+                   executor&                                                 exec);
+
+struct output_format
+{
+    standardese::markup::generator generator;
+    const char*                    extension;
+    std::string                    prefix;
+};
+
+// whether or not a document is going to be written in the format
+using document_filter
+    = std::function<bool(const standardese::markup::document_entity&, const output_format&)>;
+
+struct write_result
+{
+    std::vector<std::uint64_t> bytes; // bytes generated in each format
+    std::uint64_t              written, skipped;
+};
 
-void write_files(const documents& docs, standardese::markup::generator generator,
-                 std::string prefix, const char* extension, unsigned no_threads);
+// writes each document in all formats at once,
+// so a document is only scheduled once and is still in the cache for the other formats
+// files whose content hasn't changed are skipped,
+// files that aren't written due to the filter are kept in the manifest
+// each document is destroyed as soon as it has been written in all formats,
+// which frees its arena
+write_result write_files(documents&& docs, const std::vector<output_format>& formats,
+                         output_manifest& manifest, executor& exec,
+                         const document_filter& filter = nullptr);
 } // namespace standardese_tool
 
 #endif // STANDARDESE_TOOL_GENERATOR_HPP_INCLUDED
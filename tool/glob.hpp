@@ -0,0 +1,114 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_GLOB_HPP_INCLUDED
+#define STANDARDESE_TOOL_GLOB_HPP_INCLUDED
+
+#include <cstring>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace standardese_tool
+{
+namespace detail
+{
+    // matches a glob pattern
+    // `?` matches a single character and `*` any sequence, but neither matches a `/`,
+    // `**` matches any sequence including `/`,
+    // and `**/` at the start of a segment matches zero or more directories
+    //
+    // iterative backtracking that only remembers the last `**` and the last `*` after it,
+    // so it takes at most `O(pattern * str)` steps:
+    // a `*` doesn't cross a `/`, so if it can't match more, no earlier `*` in the same segment can,
+    // and the part between two `**` is best matched as early as possible
+    inline bool glob_match(const char* pattern, const char* str)
+    {
+        auto        begin       = pattern;
+        const char *any_pattern = nullptr, *any_str = nullptr;
+        const char *star_pattern = nullptr, *star_str = nullptr;
+        auto        any_dir = false;
+        while (true)
+        {
+            if (pattern[0] == '*' && pattern[1] == '*')
+            {
+                any_dir = pattern[2] == '/' && (pattern == begin || pattern[-1] == '/');
+                pattern += 2;
+                if (any_dir)
+                    ++pattern;
+                any_pattern  = pattern;
+                any_str      = str;
+                star_pattern = nullptr;
+            }
+            else if (*pattern == '*')
+            {
+                star_pattern = ++pattern;
+                star_str     = str;
+            }
+            else if (*str && (*pattern == '?' ? *str != '/' : *pattern == *str))
+            {
+                ++pattern;
+                ++str;
+            }
+            else if (!*pattern && !*str)
+                return true;
+            else if (star_pattern && *star_str && *star_str != '/')
+            {
+                // the last `*` matches one more character
+                pattern = star_pattern;
+                str     = ++star_str;
+            }
+            else if (any_pattern && *any_str)
+            {
+                // the last `**` matches one more character, `**/` one more directory
+                if (!any_dir)
+                    ++any_str;
+                else if (auto slash = std::strchr(any_str, '/'))
+                    any_str = slash + 1;
+                else
+                    return false;
+                pattern      = any_pattern;
+                str          = any_str;
+                star_pattern = nullptr;
+            }
+            else
+                return false;
+        }
+    }
+} // namespace detail
+
+// a list of names compiled for matching
+// exact names are looked up in a hash set, so the cost doesn't depend on their number,
+// names containing `*` or `?` are glob patterns that are tried one after the other
+class name_matcher
+{
+public:
+    name_matcher() = default;
+
+    explicit name_matcher(const std::vector<std::string>& names)
+    {
+        for (auto& name : names)
+            if (name.find_first_of("*?") == std::string::npos)
+                exact_.insert(name);
+            else
+                globs_.push_back(name);
+    }
+
+    bool matches(const std::string& name) const
+    {
+        if (exact_.count(name) != 0u)
+            return true;
+        for (auto& glob : globs_)
+            if (detail::glob_match(glob.c_str(), name.c_str()))
+                return true;
+        return false;
+    }
+
+private:
+    std::unordered_set<std::string> exact_;
+    std::vector<std::string>        globs_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_GLOB_HPP_INCLUDED
@@ -0,0 +1,200 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "incremental.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+#include <cppast/cpp_class.hpp>
+
+#include <standardese/markup/link.hpp>
+#include <standardese/markup/visitor.hpp>
+
+using namespace standardese_tool;
+
+namespace
+{
+const char graph_name[] = "dependencies";
+
+std::string get_destination(const standardese::markup::documentation_link& link)
+{
+    if (auto internal = link.internal_destination())
+    {
+        auto& document = internal.value().document();
+        return (document ? document.value().name() : "") + '#' + internal.value().id().as_str();
+    }
+    else if (auto external = link.external_destination())
+        return external.value().as_str();
+    else
+        return "";
+}
+
+const cppast::cpp_file& get_file(const cppast::cpp_entity& e)
+{
+    auto cur = type_safe::ref(e);
+    while (cur->parent())
+        cur = type_safe::ref(cur->parent().value());
+    return static_cast<const cppast::cpp_file&>(*cur);
+}
+
+const cppast::cpp_entity* get_entity(const standardese::doc_entity& doc)
+{
+    switch (doc.kind())
+    {
+    case standardese::doc_entity::cpp_entity:
+        return &static_cast<const standardese::doc_cpp_entity&>(doc).entity();
+    case standardese::doc_entity::metadata:
+        return &static_cast<const standardese::doc_metadata_entity&>(doc).entity();
+    case standardese::doc_entity::cpp_namespace:
+        return &static_cast<const standardese::doc_cpp_namespace&>(doc).namespace_();
+    case standardese::doc_entity::cpp_file:
+        return &static_cast<const standardese::doc_cpp_file&>(doc).file();
+
+    case standardese::doc_entity::excluded:
+    case standardese::doc_entity::member_group:
+        break;
+    }
+    return nullptr;
+}
+
+void add_sources(std::unordered_set<std::string>& result, const standardese::doc_entity& doc,
+                 const standardese::comment_registry& registry,
+                 const cppast::cpp_entity_index&      index)
+{
+    if (auto entity = get_entity(doc))
+    {
+        // injected members of excluded base classes are from a different file
+        result.insert(get_file(*entity).name());
+        if (auto remote = registry.get_remote_file(*entity))
+            result.insert(remote.value());
+
+        if (entity->kind() == cppast::cpp_base_class::kind())
+        {
+            // whether or not the members of the base class are injected depends on its comment
+            auto& base = static_cast<const cppast::cpp_base_class&>(*entity);
+            if (auto base_class = cppast::get_class(index, base))
+                result.insert(get_file(base_class.value()).name());
+        }
+    }
+
+    for (auto& child : doc)
+        add_sources(result, child, registry, index);
+}
+} // namespace
+
+document_sources standardese_tool::get_sources(const standardese::doc_cpp_file&     file,
+                                               const standardese::comment_registry& registry,
+                                               const cppast::cpp_entity_index&      index)
+{
+    std::unordered_set<std::string> files;
+    add_sources(files, file, registry, index);
+
+    document_sources result;
+    result.source = file.file().name();
+    files.erase(result.source);
+    result.contributors.assign(files.begin(), files.end());
+    std::sort(result.contributors.begin(), result.contributors.end());
+    return result;
+}
+
+dependency_graph::dependency_graph(fs::path directory) : directory_(std::move(directory))
+{
+    std::ifstream file((directory_ / graph_name).string());
+    if (!file.is_open())
+        return;
+
+    node*       cur = nullptr;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        auto sep   = line.find(' ');
+        auto kind  = line.substr(0, sep);
+        auto value = sep == std::string::npos ? "" : line.substr(sep + 1u);
+
+        if (kind == "document")
+            cur = &prev_nodes_[value];
+        else if (!cur)
+            // corrupted graph, treat as empty
+            break;
+        else if (kind == "source")
+            cur->sources.source = std::move(value);
+        else if (kind == "contributor")
+            cur->sources.contributors.push_back(std::move(value));
+        else if (kind == "link")
+            cur->links.push_back(std::move(value));
+        else if (kind == "unresolved")
+            cur->has_unresolved = true;
+    }
+}
+
+void dependency_graph::record(const documents& docs, const std::vector<document_sources>& sources,
+                              const input_fingerprints& inputs)
+{
+    for (auto i = std::size_t(0); i != docs.size(); ++i)
+    {
+        auto& doc = docs[i];
+        if (i >= sources.size())
+        {
+            // an index document depends on all files, so it is always written again:
+            // it is only rendered once that way, and the output manifest skips it if unchanged
+            dirty_.insert(doc->output_name().name());
+            continue;
+        }
+
+        node n;
+        n.sources = sources[i];
+
+        standardese::markup::visit(*doc, [&](const standardese::markup::entity& e) {
+            if (e.kind() == standardese::markup::entity_kind::documentation_link)
+            {
+                auto& link = static_cast<const standardese::markup::documentation_link&>(e);
+                if (link.unresolved_destination())
+                    n.has_unresolved = true;
+                else
+                    n.links.push_back(get_destination(link));
+            }
+        });
+        std::sort(n.links.begin(), n.links.end());
+        n.links.erase(std::unique(n.links.begin(), n.links.end()), n.links.end());
+
+        nodes_.emplace(doc->output_name().name(), std::move(n));
+    }
+
+    auto sources_changed = [&](const document_sources& sources) {
+        return inputs.is_changed(sources.source)
+               || std::any_of(sources.contributors.begin(), sources.contributors.end(),
+                              [&](const std::string& file) { return inputs.is_changed(file); });
+    };
+
+    for (auto& cur : nodes_)
+    {
+        auto prev = prev_nodes_.find(cur.first);
+        if (inputs.options_changed() || prev == prev_nodes_.end() || !(prev->second == cur.second))
+            // new document, different sources or links
+            dirty_.insert(cur.first);
+        else if (sources_changed(cur.second.sources))
+            // same sources as in the previous run, but their content changed
+            dirty_.insert(cur.first);
+    }
+}
+
+void dependency_graph::save() const
+{
+    fs::create_directories(directory_);
+
+    std::ofstream file((directory_ / graph_name).string());
+    for (auto& cur : nodes_)
+    {
+        file << "document " << cur.first << '\n';
+        file << "source " << cur.second.sources.source << '\n';
+        for (auto& contributor : cur.second.sources.contributors)
+            file << "contributor " << contributor << '\n';
+        for (auto& link : cur.second.links)
+            file << "link " << link << '\n';
+        if (cur.second.has_unresolved)
+            file << "unresolved\n";
+    }
+}
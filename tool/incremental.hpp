@@ -0,0 +1,89 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_INCREMENTAL_HPP_INCLUDED
+#define STANDARDESE_TOOL_INCREMENTAL_HPP_INCLUDED
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "filesystem.hpp"
+#include "generator.hpp"
+#include "input_fingerprints.hpp"
+
+namespace standardese_tool
+{
+// the input files the document of a file is generated from
+struct document_sources
+{
+    std::string              source;       // canonical path of the file itself
+    std::vector<std::string> contributors; // sorted paths of other files contributing to it
+};
+
+// computes the sources of the document of a file
+// other files contribute remote comments, or the members and comments of base classes
+// it must be called before the file is destroyed during generation
+document_sources get_sources(const standardese::doc_cpp_file&     file,
+                             const standardese::comment_registry& registry,
+                             const cppast::cpp_entity_index&      index);
+
+// the dependencies of the generated documents between two runs
+//
+// For every document of a file it records the files it was generated from
+// and the destinations of all its links after they have been resolved.
+// A document needs to be written again if one of its sources or the headers they include changed,
+// or if the destination of one of its links changed.
+// The index documents depend on all files, they're always written again;
+// the output manifest skips them if their content didn't change.
+class dependency_graph
+{
+public:
+    // reads the graph of the previous run from the directory, if there is any
+    explicit dependency_graph(fs::path directory);
+
+    // records the dependencies of the current run and compares them with the previous run
+    // the links of the documents must already be resolved
+    // `sources[i]` are the sources of the file `docs[i]` was generated from,
+    // the remaining documents are index documents
+    void record(const documents& docs, const std::vector<document_sources>& sources,
+                const input_fingerprints& inputs);
+
+    // whether or not the given document needs to be written again
+    bool is_dirty(const standardese::markup::document_entity& doc) const
+    {
+        return dirty_.count(doc.output_name().name()) != 0u;
+    }
+
+    unsigned no_dirty() const noexcept
+    {
+        return static_cast<unsigned>(dirty_.size());
+    }
+
+    // writes the graph of the current run
+    void save() const;
+
+private:
+    struct node
+    {
+        document_sources         sources;
+        std::vector<std::string> links; // sorted destinations of all links
+        bool                     has_unresolved = false;
+
+        bool operator==(const node& other) const
+        {
+            return sources.source == other.sources.source
+                   && sources.contributors == other.sources.contributors
+                   && links == other.links && has_unresolved == other.has_unresolved;
+        }
+    };
+
+    fs::path                              directory_;
+    std::unordered_map<std::string, node> prev_nodes_, nodes_; // output name -> node
+    std::unordered_set<std::string>       dirty_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_INCREMENTAL_HPP_INCLUDED
@@ -0,0 +1,277 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "input_fingerprints.hpp"
+
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+
+#include "executor.hpp"
+
+using namespace standardese_tool;
+
+namespace
+{
+const char manifest_name[] = "inputs";
+
+std::string read_file(const fs::path& path)
+{
+    std::ifstream      file(path.string(), std::ios::binary);
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    return stream.str();
+}
+
+struct include_name
+{
+    std::string name;
+    bool        quoted;
+};
+
+// finds all include directives in the file
+// this is a purely textual scan, conditional includes are treated as taken
+std::vector<include_name> scan_includes(const std::string& content)
+{
+    std::vector<include_name> result;
+
+    auto skip_ws = [](const char*& ptr, const char* end) {
+        while (ptr != end && (*ptr == ' ' || *ptr == '\t'))
+            ++ptr;
+    };
+
+    auto begin = content.c_str();
+    auto end   = begin + content.size();
+    for (auto line = begin; line < end;)
+    {
+        auto line_end = static_cast<const char*>(std::memchr(line, '\n', std::size_t(end - line)));
+        if (!line_end)
+            line_end = end;
+
+        auto ptr = line;
+        skip_ws(ptr, line_end);
+        if (ptr != line_end && *ptr == '#')
+        {
+            ++ptr;
+            skip_ws(ptr, line_end);
+            if (std::size_t(line_end - ptr) > 7u && std::strncmp(ptr, "include", 7u) == 0)
+            {
+                ptr += 7u;
+                skip_ws(ptr, line_end);
+                if (ptr != line_end && (*ptr == '"' || *ptr == '<'))
+                {
+                    auto closing = *ptr == '"' ? '"' : '>';
+                    auto name    = ++ptr;
+                    while (ptr != line_end && *ptr != closing)
+                        ++ptr;
+                    if (ptr != line_end)
+                        result.push_back({std::string(name, ptr), closing == '"'});
+                }
+            }
+        }
+
+        line = line_end + 1;
+    }
+
+    return result;
+}
+
+std::vector<fs::path> get_include_dirs(const cppast::libclang_compile_config& config)
+{
+    std::vector<fs::path> result;
+
+    auto& flags = config.get_flags();
+    for (auto iter = flags.begin(); iter != flags.end(); ++iter)
+    {
+        if (*iter == "-I" || *iter == "-isystem")
+        {
+            if (std::next(iter) != flags.end())
+                result.push_back(*++iter);
+        }
+        else if (iter->compare(0, 2, "-I") == 0)
+            result.push_back(iter->substr(2));
+        else if (iter->compare(0, 8, "-isystem") == 0)
+            result.push_back(iter->substr(8));
+    }
+
+    return result;
+}
+
+// the include graph of all files, shared between the inputs
+class include_graph
+{
+public:
+    struct node
+    {
+        std::uint64_t content;
+        // the resolved path of the includes,
+        // or the include name prefixed with '<' if it could not be resolved
+        std::vector<std::string> includes;
+    };
+
+    const node& get(const fs::path& path, const std::vector<fs::path>& include_dirs,
+                    std::uint64_t include_dirs_hash)
+    {
+        auto key = path.generic_string() + '\n' + std::to_string(include_dirs_hash);
+
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto                         iter = nodes_.find(key);
+        if (iter != nodes_.end())
+            return iter->second;
+        lock.unlock();
+
+        auto n = read_node(path, include_dirs);
+
+        lock.lock();
+        // if another thread was faster, this has no effect
+        return nodes_.emplace(std::move(key), std::move(n)).first->second;
+    }
+
+private:
+    static node read_node(const fs::path& path, const std::vector<fs::path>& include_dirs)
+    {
+        auto content = read_file(path);
+
+        node result;
+        result.content = fingerprint().add(content).value();
+        for (auto& include : scan_includes(content))
+        {
+            fs::path resolved;
+            if (include.quoted && fs::exists(path.parent_path() / include.name))
+                resolved = path.parent_path() / include.name;
+            else
+                for (auto& dir : include_dirs)
+                    if (fs::exists(dir / include.name))
+                    {
+                        resolved = dir / include.name;
+                        break;
+                    }
+
+            if (resolved.empty())
+                result.includes.push_back('<' + include.name);
+            else
+                result.includes.push_back(resolved.lexically_normal().generic_string());
+        }
+
+        return result;
+    }
+
+    std::mutex                            mutex_;
+    std::unordered_map<std::string, node> nodes_;
+};
+
+std::uint64_t get_key(include_graph& graph, const fs::path& path,
+                      const cppast::libclang_compile_config& config)
+{
+    fingerprint result;
+
+    for (auto& flag : config.get_flags())
+        result.add(flag);
+
+    auto          include_dirs = get_include_dirs(config);
+    std::uint64_t include_dirs_hash;
+    {
+        fingerprint hash;
+        for (auto& dir : include_dirs)
+            hash.add(dir.generic_string());
+        include_dirs_hash = hash.value();
+    }
+
+    // depth first traversal over all included files
+    std::unordered_set<std::string> visited;
+    std::vector<std::string>        stack;
+    stack.push_back(fs::absolute(path).lexically_normal().generic_string());
+    while (!stack.empty())
+    {
+        auto cur = std::move(stack.back());
+        stack.pop_back();
+        if (!visited.insert(cur).second)
+            continue;
+
+        result.add(cur);
+        if (cur.front() == '<')
+            // unresolved include, name is all we have
+            continue;
+
+        auto& node = graph.get(cur, include_dirs, include_dirs_hash);
+        result.add(node.content);
+        // push in reverse, so they're visited in order
+        for (auto iter = node.includes.rbegin(); iter != node.includes.rend(); ++iter)
+            stack.push_back(*iter);
+    }
+
+    return result.value();
+}
+} // namespace
+
+input_fingerprints::input_fingerprints(fs::path directory, std::uint64_t options)
+: directory_(std::move(directory)), prev_options_(0u), options_(options), no_unchanged_(0u),
+  no_changed_(0u)
+{
+    std::ifstream manifest((directory_ / manifest_name).string());
+    if (!manifest.is_open())
+        return;
+
+    std::string header;
+    if (!(manifest >> header >> std::hex >> prev_options_) || header != "options")
+    {
+        // corrupted manifest, treat as empty
+        prev_options_ = 0u;
+        return;
+    }
+
+    std::uint64_t key;
+    while (manifest >> std::hex >> key)
+    {
+        manifest.get(); // skip separator
+        std::string path;
+        if (!std::getline(manifest, path))
+            break;
+        prev_keys_.emplace(std::move(path), key);
+    }
+}
+
+void input_fingerprints::update(
+    const cppast::libclang_compile_config&                            config,
+    const type_safe::optional<cppast::libclang_compilation_database>& database,
+    const std::vector<input_file>& files, executor& exec)
+{
+    include_graph              graph;
+    std::vector<std::uint64_t> keys(files.size());
+    exec.parallel_for(files.size(), [&](std::size_t i) {
+        auto db_config = database.map([&](const cppast::libclang_compilation_database& db) {
+            return cppast::find_config_for(db, files[i].path.generic_string());
+        });
+        keys[i] = get_key(graph, files[i].path, db_config.value_or(config));
+    });
+
+    for (auto i = std::size_t(0); i != files.size(); ++i)
+    {
+        // same path as passed to the parser
+        auto path = files[i].canonical;
+
+        auto prev = prev_keys_.find(path);
+        if (prev != prev_keys_.end() && prev->second == keys[i])
+            ++no_unchanged_;
+        else
+        {
+            ++no_changed_;
+            changed_.insert(path);
+        }
+
+        keys_[std::move(path)] = keys[i];
+    }
+}
+
+void input_fingerprints::save() const
+{
+    fs::create_directories(directory_);
+
+    std::ofstream manifest((directory_ / manifest_name).string());
+    manifest << "options " << std::hex << options_ << '\n';
+    for (auto& key : keys_)
+        manifest << std::hex << key.second << ' ' << key.first << '\n';
+}
@@ -0,0 +1,127 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_INPUT_FINGERPRINTS_HPP_INCLUDED
+#define STANDARDESE_TOOL_INPUT_FINGERPRINTS_HPP_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <cppast/libclang_parser.hpp>
+
+#include "executor.hpp"
+#include "filesystem.hpp"
+#include "generator.hpp"
+
+namespace standardese_tool
+{
+// 64bit FNV-1a hash
+class fingerprint
+{
+public:
+    fingerprint() noexcept : value_(14695981039346656037ull) {}
+
+    fingerprint& add(const char* data, std::size_t size) noexcept
+    {
+        for (auto ptr = data; ptr != data + size; ++ptr)
+        {
+            value_ ^= static_cast<unsigned char>(*ptr);
+            value_ *= 1099511628211ull;
+        }
+        return *this;
+    }
+
+    fingerprint& add(const std::string& str) noexcept
+    {
+        // include the terminator, so "ab" + "c" differs from "a" + "bc"
+        return add(str.c_str(), str.size() + 1u);
+    }
+
+    fingerprint& add(std::uint64_t value) noexcept
+    {
+        char bytes[8];
+        for (auto i = 0u; i != 8u; ++i)
+            bytes[i] = char((value >> (i * 8u)) & 0xFF);
+        return add(bytes, 8u);
+    }
+
+    std::uint64_t value() const noexcept
+    {
+        return value_;
+    }
+
+private:
+    std::uint64_t value_;
+};
+
+// the fingerprints of the inputs of a run
+//
+// The fingerprint of a file is the hash of its content, the content of all files it
+// (transitively) includes and the effective compile flags.
+// It doesn't cache any parse results, cppast entities cannot be serialized:
+// it is only used to decide whether a run can be skipped
+// and which documents have to be written again in incremental mode.
+// The includes are found by a textual scan that treats conditional includes as taken,
+// and they're only resolved against the include directories of the compile flags;
+// system headers found through the compiler's default search paths are only tracked by name.
+class input_fingerprints
+{
+public:
+    // reads the fingerprints of the previous run from the directory, if there are any
+    // options is a hash of all options affecting the output, including the tool version
+    explicit input_fingerprints(fs::path directory, std::uint64_t options);
+
+    // computes the fingerprints of the input files and compares them with the previous run
+    void update(const cppast::libclang_compile_config&                            config,
+                const type_safe::optional<cppast::libclang_compilation_database>& database,
+                const std::vector<input_file>& files, executor& exec);
+
+    // whether or not neither the inputs nor the options have changed since the previous run
+    // the run can only be skipped if the outputs of the previous run are unchanged as well
+    bool is_unchanged() const noexcept
+    {
+        return options_ == prev_options_ && no_changed_ == 0u
+               && keys_.size() == prev_keys_.size();
+    }
+
+    // whether or not the options have changed since the previous run
+    bool options_changed() const noexcept
+    {
+        return options_ != prev_options_;
+    }
+
+    // whether or not the file with the given (canonical) path has changed since the previous run,
+    // or is no longer an input
+    bool is_changed(const std::string& path) const
+    {
+        return changed_.count(path) != 0u
+               || (keys_.count(path) == 0u && prev_keys_.count(path) != 0u);
+    }
+
+    unsigned no_unchanged() const noexcept
+    {
+        return no_unchanged_;
+    }
+
+    unsigned no_changed() const noexcept
+    {
+        return no_changed_;
+    }
+
+    // writes the fingerprints of the current run
+    void save() const;
+
+private:
+    fs::path                                       directory_;
+    std::unordered_map<std::string, std::uint64_t> prev_keys_, keys_; // path -> key
+    std::unordered_set<std::string>                changed_;
+    std::uint64_t                                  prev_options_, options_;
+    unsigned                                       no_unchanged_, no_changed_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_INPUT_FINGERPRINTS_HPP_INCLUDED
@@ -0,0 +1,52 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "logger.hpp"
+
+using namespace standardese_tool;
+
+namespace
+{
+thread_local diagnostic_buffer* current_buffer = nullptr;
+
+class buffer_logger final : public cppast::diagnostic_logger
+{
+public:
+    // verbosity is checked by the default logger
+    buffer_logger() noexcept : cppast::diagnostic_logger(true) {}
+
+private:
+    bool do_log(const char* source, const cppast::diagnostic& d) const override
+    {
+        if (!current_buffer)
+            return cppast::default_logger()->log(source, d);
+
+        current_buffer->add(source, d);
+        return true;
+    }
+};
+} // namespace
+
+type_safe::object_ref<const cppast::diagnostic_logger> diagnostic_buffer::logger() noexcept
+{
+    static const buffer_logger logger;
+    return type_safe::ref(logger);
+}
+
+diagnostic_buffer::capture::capture(diagnostic_buffer& buffer) noexcept : prev_(current_buffer)
+{
+    current_buffer = &buffer;
+}
+
+diagnostic_buffer::capture::~capture() noexcept
+{
+    current_buffer = prev_;
+}
+
+void diagnostic_buffer::replay()
+{
+    for (auto& e : entries_)
+        cppast::default_logger()->log(e.source.c_str(), e.diagnostic);
+    entries_.clear();
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_LOGGER_HPP_INCLUDED
+#define STANDARDESE_TOOL_LOGGER_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <cppast/diagnostic_logger.hpp>
+
+namespace standardese_tool
+{
+// collects diagnostics, so they can be logged in a deterministic order
+// instead of the order the tasks happened to finish
+class diagnostic_buffer
+{
+public:
+    // a logger that adds to the buffer captured by the current thread,
+    // or logs to the default logger if there is none
+    static type_safe::object_ref<const cppast::diagnostic_logger> logger() noexcept;
+
+    // captures all diagnostics of the current thread during its lifetime
+    class capture
+    {
+    public:
+        explicit capture(diagnostic_buffer& buffer) noexcept;
+        ~capture() noexcept;
+
+        capture(const capture&) = delete;
+        capture& operator=(const capture&) = delete;
+
+    private:
+        diagnostic_buffer* prev_;
+    };
+
+    void add(const char* source, const cppast::diagnostic& d)
+    {
+        entries_.push_back({source, d});
+    }
+
+    // logs all diagnostics to the default logger and clears the buffer
+    void replay();
+
+private:
+    struct entry
+    {
+        std::string        source;
+        cppast::diagnostic diagnostic;
+    };
+
+    std::vector<entry> entries_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_LOGGER_HPP_INCLUDED
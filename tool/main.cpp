@@ -4,12 +4,20 @@
 
 #include <fstream>
 #include <iostream>
+#include <set>
+#include <unordered_map>
 
 #include <boost/program_options.hpp>
 
+#include "executor.hpp"
 #include "filesystem.hpp"
 #include "generator.hpp"
-#include "thread_pool.hpp"
+#include "incremental.hpp"
+#include "input_fingerprints.hpp"
+#include "logger.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "watcher.hpp"
 
 namespace po = boost::program_options;
 namespace fs = boost::filesystem;
@@ -167,7 +175,62 @@ type_safe::optional<cppast::libclang_compilation_database> get_compilation_datab
         return type_safe::nullopt;
 }
 
-std::vector<standardese_tool::input_file> get_input(const po::variables_map& options)
+void add_option_value(standardese_tool::fingerprint& result, const po::variable_value& value)
+{
+    auto& any = value.value();
+    if (auto b = boost::any_cast<bool>(&any))
+        result.add(std::uint64_t(*b));
+    else if (auto u = boost::any_cast<unsigned>(&any))
+        result.add(std::uint64_t(*u));
+    else if (auto c = boost::any_cast<char>(&any))
+        result.add(std::string(1u, *c));
+    else if (auto str = boost::any_cast<std::string>(&any))
+        result.add(*str);
+    else if (auto strs = boost::any_cast<std::vector<std::string>>(&any))
+    {
+        result.add(std::uint64_t(strs->size()));
+        for (auto& str : *strs)
+            result.add(str);
+    }
+    else if (auto paths = boost::any_cast<std::vector<fs::path>>(&any))
+    {
+        // the same input spelled differently results in the same output names
+        result.add(std::uint64_t(paths->size()));
+        for (auto& path : *paths)
+        {
+            boost::system::error_code ec;
+            auto                      canonical = fs::canonical(path, ec);
+            result.add((ec ? path : canonical).generic_string());
+        }
+    }
+    else
+        throw std::logic_error("unexpected option type");
+}
+
+std::uint64_t get_options_hash(const po::variables_map& options)
+{
+    // options that don't affect the generated documentation,
+    // the options read from the config file are part of the map already
+    static const std::set<std::string> ignored
+        = {"version", "help",  "config", "verbose", "jobs", "cache-dir", "incremental",
+           "stats",   "trace", "watch"};
+
+    standardese_tool::fingerprint result;
+    // a different version might generate different output
+    result.add(std::uint64_t(STANDARDESE_VERSION_MAJOR))
+        .add(std::uint64_t(STANDARDESE_VERSION_MINOR));
+    // the map is sorted by name, so the order of the arguments doesn't matter
+    for (auto& option : options)
+        if (ignored.count(option.first) == 0u)
+        {
+            result.add(option.first);
+            add_option_value(result, option.second);
+        }
+
+    return result.value();
+}
+
+standardese_tool::input_filter get_input_filter(const po::variables_map& options)
 {
     auto source_ext = get_option<std::vector<std::string>>(options, "input.source_ext").value();
     auto blacklist_ext
@@ -177,7 +240,16 @@ std::vector<standardese_tool::input_file> get_input(const po::variables_map& opt
     auto blacklist_dirs
         = get_option<std::vector<std::string>>(options, "input.blacklist_dir").value();
     auto blacklist_dotfiles = get_option<bool>(options, "input.blacklist_dotfiles").value();
-    auto force_blacklist    = get_option<bool>(options, "input.force_blacklist").value();
+
+    return standardese_tool::input_filter(source_ext, blacklist_ext, blacklist_files,
+                                          blacklist_dirs, blacklist_dotfiles);
+}
+
+std::vector<standardese_tool::input_file> get_input(const po::variables_map&   options,
+                                                    standardese_tool::executor& exec)
+{
+    auto filter          = get_input_filter(options);
+    auto force_blacklist = get_option<bool>(options, "input.force_blacklist").value();
 
     auto input_files = get_option<std::vector<fs::path>>(options, "input-files");
     if (!input_files)
@@ -185,13 +257,35 @@ std::vector<standardese_tool::input_file> get_input(const po::variables_map& opt
 
     std::vector<standardese_tool::input_file> files;
     for (auto& file : input_files.value())
-        standardese_tool::handle_path(file, source_ext, blacklist_ext, blacklist_files,
-                                      blacklist_dirs, blacklist_dotfiles, force_blacklist,
+        standardese_tool::handle_path(file, filter, force_blacklist, exec,
                                       [&](bool, const fs::path& path, const fs::path& relative) {
-                                          files.push_back({path, relative});
+                                          files.push_back({path, relative, ""});
                                       });
 
-    return files;
+    exec.parallel_for(files.size(), [&](std::size_t i) {
+        files[i].canonical = fs::canonical(files[i].path).generic_string();
+    });
+
+    // a file reachable through multiple inputs or symlinks is only parsed once,
+    // its output name is the one of its first occurrence
+    auto verbose = get_option<bool>(options, "verbose").value();
+    std::vector<standardese_tool::input_file>    result;
+    std::unordered_map<std::string, std::size_t> first;
+    for (auto& file : files)
+    {
+        auto inserted = first.emplace(file.canonical, result.size());
+        if (inserted.second)
+            result.push_back(std::move(file));
+        else if (verbose)
+        {
+            auto& original = result[inserted.first->second];
+            std::clog << "skipping '" << file.path.generic_string() << "': same file as '"
+                      << original.path.generic_string() << "', documented as '"
+                      << original.relative.generic_string() << "'\n";
+        }
+    }
+
+    return result;
 }
 
 standardese::comment::config get_comment_config(const po::variables_map& options)
@@ -318,7 +412,17 @@ int main(int argc, char* argv[])
         ("verbose,v", po::value<bool>()->implicit_value(true)->default_value(false),
          "prints more information")
         ("jobs,j", po::value<unsigned>()->default_value(standardese_tool::default_no_threads()),
-         "sets the number of threads to use");
+         "sets the number of threads to use")
+        ("cache-dir", po::value<fs::path>(),
+         "directory where the fingerprints of the inputs and outputs are stored, if neither changed since the last run, the run is skipped")
+        ("incremental", po::value<bool>()->implicit_value(true)->default_value(false),
+         "only write the documents whose inputs changed since the last run, requires --cache-dir")
+        ("stats", po::value<fs::path>(),
+         "writes statistics about the run to the given file, as CSV if the extension is .csv, JSON otherwise")
+        ("trace", po::value<fs::path>(),
+         "writes a timeline of the run to the given file, in the trace event format of chrome://tracing and Perfetto")
+        ("watch", po::value<bool>()->implicit_value(true)->default_value(false),
+         "keeps running and runs again from scratch whenever an input file changes (Linux only)");
 
     configuration.add_options()
         ("input.source_ext",
@@ -330,10 +434,10 @@ int main(int argc, char* argv[])
          R"(file extension that is forbidden (e.g. ".md"; "." for no extension))")
         ("input.blacklist_file",
          po::value<std::vector<std::string>>()->default_value({}, "(none)"),
-         "file that is forbidden, relative to traversed directory")
+         "file that is forbidden, relative to traversed directory, may be a glob pattern with *, ** and ?")
         ("input.blacklist_dir",
          po::value<std::vector<std::string>>()->default_value({}, "(none)"),
-         "directory that is forbidden, relative to traversed directory")
+         "directory that is forbidden, relative to traversed directory, may be a glob pattern with *, ** and ?")
         ("input.blacklist_dotfiles",
          po::value<bool>()->implicit_value(true)->default_value(true),
          "whether or not dotfiles are blacklisted")
@@ -427,11 +531,10 @@ int main(int argc, char* argv[])
             print_usage(argv[0], generic, configuration);
         else
         {
-            auto no_threads = get_option<unsigned>(options, "jobs").value();
+            standardese_tool::executor exec(get_option<unsigned>(options, "jobs").value());
 
             auto compile_config = get_compile_config(options);
             auto database       = get_compilation_database(options);
-            auto input          = get_input(options);
 
             auto comment_config    = get_comment_config(options);
             auto synopsis_config   = get_synopsis_config(options);
@@ -442,45 +545,209 @@ int main(int argc, char* argv[])
             auto formats = get_formats(options);
             auto prefix  = get_option<std::string>(options, "output.prefix").value();
 
-            standardese::linker linker;
-            register_external_documentations(linker, options);
+            auto incremental = get_option<bool>(options, "incremental").value();
+            if (incremental && !has_option(options, "cache-dir"))
+                throw std::invalid_argument("incremental mode requires --cache-dir");
 
-            try
-            {
-                cppast::cpp_entity_index index;
-
-                std::clog << "parsing C++ files...\n";
-                auto parsed
-                    = standardese_tool::parse(compile_config, database, input, index, no_threads);
-                if (!parsed)
-                    return 1;
-
-                std::clog << "parsing documentation comments...\n";
-                auto comments
-                    = standardese_tool::parse_comments(comment_config, parsed.value(), no_threads);
-                auto files
-                    = standardese_tool::build_files(comments, index, std::move(parsed.value()),
-                                                    blacklist, no_threads);
-
-                std::clog << "generating documentation...\n";
-                auto docs = standardese_tool::generate(generation_config, synopsis_config, comments,
-                                                       index, linker, files, no_threads);
-
-                for (auto& format : formats)
+            auto trace_file = get_option<fs::path>(options, "trace");
+            if (trace_file)
+                standardese_tool::enable_tracing();
+
+            // one run of the tool, returns the exit code
+            auto run = [&]() -> int {
+                auto stats_file = get_option<fs::path>(options, "stats");
+
+                standardese_tool::run_statistics stats;
+                auto                             write_reports = [&] {
+                    stats.end_phase();
+                    if (stats_file)
+                        stats.write(stats_file.value());
+                    if (trace_file)
+                        standardese_tool::write_trace(trace_file.value());
+                };
+
+                stats.start_phase("input");
+                auto input = get_input(options, exec);
+                stats.add_counter("files", input.size());
+
+                standardese::linker linker;
+                register_external_documentations(linker, options);
+
+                standardese_tool::output_manifest manifest(
+                    get_option<fs::path>(options, "cache-dir"));
+
+                type_safe::optional<standardese_tool::input_fingerprints> fingerprints;
+                if (auto dir = get_option<fs::path>(options, "cache-dir"))
                 {
-                    std::clog << "writing files in format '" << format.second << "'...\n";
-
-                    auto format_prefix
-                        = formats.size() > 1u ? std::string(format.second) + '/' + prefix : prefix;
-                    if (!format_prefix.empty())
-                        fs::create_directories(fs::path(format_prefix).parent_path());
-                    standardese_tool::write_files(docs, format.first, std::move(format_prefix),
-                                                  format.second, no_threads);
+                    stats.start_phase("fingerprints");
+                    fingerprints.emplace(dir.value(), get_options_hash(options));
+                    fingerprints.value().update(compile_config, database, input, exec);
+
+                    std::clog << "inputs: " << fingerprints.value().no_unchanged()
+                              << " unchanged, " << fingerprints.value().no_changed()
+                              << " changed\n";
+                    if (fingerprints.value().is_unchanged() && manifest.is_unchanged(exec))
+                    {
+                        std::clog << "documentation is up to date\n";
+                        write_reports();
+                        return 0;
+                    }
                 }
-            }
-            catch (std::exception& ex)
+
+                try
+                {
+                    cppast::cpp_entity_index index;
+
+                    std::clog << "parsing C++ files and documentation comments...\n";
+                    stats.start_phase("parse");
+                    // diagnostics are collected per file and logged in order
+                    auto comment_logger = standardese_tool::diagnostic_buffer::logger();
+                    standardese::file_comment_parser comment_parser(comment_logger,
+                                                                    comment_config);
+                    auto parsed = standardese_tool::parse(compile_config, database, input, index,
+                                                          comment_parser, exec);
+                    if (!parsed)
+                        return 1;
+
+                    std::clog << "matching documentation comments...\n";
+                    stats.start_phase("comments");
+                    auto comments = comment_parser.finish();
+                    stats.add_counter("comments", comments.no_comments());
+                    stats.add_counter("member_groups", comments.no_groups());
+
+                    stats.start_phase("build");
+                    auto files = standardese_tool::build_files(comments, index,
+                                                               std::move(parsed.value()), blacklist,
+                                                               exec);
+
+                    // the files are destroyed during generation
+                    std::vector<standardese_tool::document_sources> sources(files.size());
+                    if (fingerprints)
+                        exec.parallel_for(files.size(), [&](std::size_t i) {
+                            sources[i] = standardese_tool::get_sources(*files[i], comments, index);
+                        });
+
+                    std::clog << "generating documentation...\n";
+                    stats.start_phase("generate");
+                    auto docs = standardese_tool::generate(generation_config, synopsis_config,
+                                                           comments, index, linker,
+                                                           std::move(files), exec);
+                    stats.add_counters(docs);
+
+                    // always record the dependencies, so they're up to date for the next run
+                    type_safe::optional<standardese_tool::dependency_graph> dependencies;
+                    if (fingerprints)
+                    {
+                        dependencies.emplace(get_option<fs::path>(options, "cache-dir").value());
+                        dependencies.value().record(docs, sources, fingerprints.value());
+                        if (incremental)
+                            std::clog << "writing " << dependencies.value().no_dirty() << " of "
+                                      << docs.size() << " documents\n";
+                    }
+
+                    std::clog << "writing files...\n";
+                    stats.start_phase("write");
+
+                    std::vector<standardese_tool::output_format> output_formats;
+                    for (auto& format : formats)
+                    {
+                        auto format_prefix = formats.size() > 1u
+                                                 ? std::string(format.second) + '/' + prefix
+                                                 : prefix;
+                        if (!format_prefix.empty())
+                            fs::create_directories(fs::path(format_prefix).parent_path());
+                        output_formats.push_back({format.first, format.second, format_prefix});
+                    }
+
+                    standardese_tool::document_filter filter;
+                    if (incremental)
+                        filter = [&](const standardese::markup::document_entity& doc,
+                                     const standardese_tool::output_format&      format) {
+                            // also write documents whose output has been removed
+                            return dependencies.value().is_dirty(doc)
+                                   || !fs::exists(format.prefix
+                                                  + doc.output_name().file_name(format.extension));
+                        };
+                    // the documents are destroyed once written
+                    auto result  = standardese_tool::write_files(std::move(docs), output_formats,
+                                                                manifest, exec, filter);
+                    auto removed = manifest.remove_stale();
+                    std::clog << "wrote " << result.written << " files, " << result.skipped
+                              << " unchanged, " << removed << " removed\n";
+
+                    for (auto i = std::size_t(0); i != formats.size(); ++i)
+                        stats.add_counter(std::string("output_bytes.") + formats[i].second,
+                                          result.bytes[i]);
+                    stats.add_counter("files_written", result.written);
+                    stats.add_counter("files_skipped", result.skipped);
+                    stats.add_counter("files_removed", removed);
+
+                    if (fingerprints)
+                        fingerprints.value().save();
+                    if (dependencies)
+                        dependencies.value().save();
+                    manifest.save();
+
+                    write_reports();
+
+                    if (get_option<bool>(options, "verbose").value())
+                    {
+                        auto stats = exec.statistics();
+                        for (auto i = 0u; i != stats.size(); ++i)
+                            std::clog << "worker " << i << ": "
+                                      << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                             stats[i].busy)
+                                             .count()
+                                      << "ms busy, "
+                                      << std::chrono::duration_cast<std::chrono::milliseconds>(
+                                             stats[i].idle)
+                                             .count()
+                                      << "ms idle, " << stats[i].tasks << " tasks, "
+                                      << stats[i].steals << " steals\n";
+                    }
+                }
+                catch (std::exception& ex)
+                {
+                    std::cerr << "error: " << ex.what() << '\n';
+                }
+
+                return 0;
+            };
+
+            if (!get_option<bool>(options, "watch").value())
+                return run();
+
+            auto input_files = get_option<std::vector<fs::path>>(options, "input-files");
+            if (!input_files)
+                throw std::invalid_argument("no input files specified");
+
+            // every change runs the whole pipeline again, nothing is kept between the runs:
+            // cppast's entity index and the comment registry can't drop the entities of one file
+            auto filter          = get_input_filter(options);
+            auto force_blacklist = get_option<bool>(options, "input.force_blacklist").value();
+
+            std::vector<fs::path> watched;
+            for (auto& path : input_files.value())
+                // like handle_path(), explicitly given files are only filtered if forced
+                if (!force_blacklist || fs::is_directory(path) || filter.is_valid(path, "", false))
+                    watched.push_back(path);
+
+            // watch before the first run, so no change is missed
+            standardese_tool::file_watcher watcher(watched, std::move(filter));
+            while (true)
             {
-                std::cerr << "error: " << ex.what() << '\n';
+                try
+                {
+                    run();
+                }
+                catch (std::exception& ex)
+                {
+                    // e.g. an input has been removed while collecting them, keep watching
+                    std::cerr << "error: " << ex.what() << '\n';
+                }
+
+                std::clog << "watching for changes...\n";
+                watcher.wait(std::chrono::milliseconds(100));
             }
         }
     }
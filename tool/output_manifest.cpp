@@ -0,0 +1,141 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "output_manifest.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+#include <standardese/markup/generator.hpp>
+
+#include "input_fingerprints.hpp"
+
+using namespace standardese_tool;
+
+namespace
+{
+const char manifest_name[] = "outputs";
+
+// the manifest is independent of the working directory
+std::string get_key(const std::string& path)
+{
+    return fs::absolute(path).lexically_normal().generic_string();
+}
+
+bool has_content(const std::string& path, const std::string& content)
+{
+    boost::system::error_code ec;
+    auto                      size = fs::file_size(path, ec);
+    if (ec || size != content.size())
+        return false;
+
+    std::ifstream file(path, std::ios::binary);
+    return std::equal(content.begin(), content.end(), std::istreambuf_iterator<char>(file));
+}
+} // namespace
+
+output_manifest::output_manifest(type_safe::optional<fs::path> directory)
+: directory_(std::move(directory))
+{
+    if (!directory_)
+        return;
+
+    std::ifstream manifest((directory_.value() / manifest_name).string());
+    std::uint64_t hash;
+    while (manifest >> std::hex >> hash)
+    {
+        manifest.get(); // skip separator
+        std::string path;
+        if (!std::getline(manifest, path))
+            break;
+        prev_hashes_.emplace(std::move(path), hash);
+    }
+}
+
+bool output_manifest::is_unchanged(executor& exec) const
+{
+    if (prev_hashes_.empty())
+        return false;
+
+    std::vector<const std::pair<const std::string, std::uint64_t>*> files;
+    for (auto& prev : prev_hashes_)
+        files.push_back(&prev);
+
+    std::atomic<bool> result(true);
+    exec.parallel_for(files.size(), [&](std::size_t i) {
+        if (!result.load(std::memory_order_relaxed))
+            return;
+
+        // the output might have been edited or removed by hand
+        std::ifstream file(files[i]->first, std::ios::binary);
+        if (!file.is_open())
+            result = false;
+        else
+        {
+            std::string content{std::istreambuf_iterator<char>(file),
+                                std::istreambuf_iterator<char>()};
+            if (fingerprint().add(content.data(), content.size()).value() != files[i]->second)
+                result = false;
+        }
+    });
+    return result;
+}
+
+bool output_manifest::write(const std::string& path, const std::string& content)
+{
+    auto hash = fingerprint().add(content.data(), content.size()).value();
+
+    // always compare with the actual file: it might have been edited or truncated by hand,
+    // and a matching hash in the manifest would keep it that way
+    auto unchanged = has_content(path, content);
+    if (!unchanged)
+    {
+        standardese::markup::file_output file(path);
+        file.write(content.data(), content.size());
+        file.close();
+    }
+
+    auto                        key = get_key(path);
+    std::lock_guard<std::mutex> lock(mutex_);
+    hashes_[std::move(key)] = hash;
+    return !unchanged;
+}
+
+void output_manifest::keep(const std::string& path)
+{
+    auto prev = prev_hashes_.find(get_key(path));
+    if (prev == prev_hashes_.end())
+        return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    hashes_.insert(*prev);
+}
+
+unsigned output_manifest::remove_stale() const
+{
+    auto count = 0u;
+    for (auto& prev : prev_hashes_)
+        if (hashes_.count(prev.first) == 0u)
+        {
+            boost::system::error_code ec;
+            if (fs::remove(prev.first, ec))
+                ++count;
+        }
+    return count;
+}
+
+void output_manifest::save() const
+{
+    if (!directory_)
+        return;
+    fs::create_directories(directory_.value());
+
+    std::ofstream manifest((directory_.value() / manifest_name).string());
+    for (auto& hash : hashes_)
+        manifest << std::hex << hash.second << ' ' << hash.first << '\n';
+}
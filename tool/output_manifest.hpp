@@ -0,0 +1,59 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_OUTPUT_MANIFEST_HPP_INCLUDED
+#define STANDARDESE_TOOL_OUTPUT_MANIFEST_HPP_INCLUDED
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <type_safe/optional.hpp>
+
+#include "executor.hpp"
+#include "filesystem.hpp"
+
+namespace standardese_tool
+{
+// the content hashes of the output files
+//
+// A file is only written if its content differs from the existing file, so unchanged files keep
+// their modification time. The hashes of the previous run are read from a manifest in the cache
+// directory, they're used to check whether a whole run can be skipped
+// and to remove the files of the previous run that are no longer generated.
+class output_manifest
+{
+public:
+    // reads the manifest of the previous run from the directory, if there is any
+    explicit output_manifest(type_safe::optional<fs::path> directory);
+
+    // whether or not all files of the previous run still exist with the recorded content
+    // returns false if there is no previous run
+    bool is_unchanged(executor& exec) const;
+
+    // writes the content to the file, unless it already has that content
+    // returns whether or not the file was written
+    // this function is thread safe
+    bool write(const std::string& path, const std::string& content);
+
+    // keeps a file of the previous run that hasn't been generated again
+    // this function is thread safe
+    void keep(const std::string& path);
+
+    // removes the files of the previous run that have neither been written nor kept
+    // returns the number of removed files
+    unsigned remove_stale() const;
+
+    // writes the manifest of the current run, if there is a directory
+    void save() const;
+
+private:
+    type_safe::optional<fs::path>                  directory_;
+    std::unordered_map<std::string, std::uint64_t> prev_hashes_, hashes_; // path -> hash
+    std::mutex                                     mutex_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_OUTPUT_MANIFEST_HPP_INCLUDED
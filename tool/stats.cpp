@@ -0,0 +1,184 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "stats.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include <standardese/markup/link.hpp>
+#include <standardese/markup/visitor.hpp>
+
+#if defined(__unix__) || defined(__APPLE__)
+#    include <sys/resource.h>
+#endif
+
+using namespace standardese_tool;
+
+namespace
+{
+struct resource_usage
+{
+    double        cpu_seconds;
+    std::uint64_t peak_rss_bytes;
+};
+
+// resets the peak memory usage of the process to the current usage
+// returns false if that isn't supported
+bool reset_peak_rss()
+{
+#if defined(__linux__)
+    // supported since Linux 4.0
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << '5' << std::flush;
+    return clear_refs.good();
+#else
+    return false;
+#endif
+}
+
+#if defined(__linux__)
+// the peak memory usage since the last reset
+std::uint64_t get_reset_peak_rss()
+{
+    std::ifstream status("/proc/self/status");
+    std::string   line;
+    while (std::getline(status, line))
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            // in kB
+            return std::strtoull(line.c_str() + 6, nullptr, 10) * 1024u;
+    return 0u;
+}
+#endif
+
+// CPU time of all threads and the peak memory usage,
+// either since the last reset or of the process so far
+resource_usage get_resource_usage(bool since_reset)
+{
+#if defined(__unix__) || defined(__APPLE__)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return {0.0, 0u};
+
+    auto to_seconds = [](const timeval& t) { return double(t.tv_sec) + double(t.tv_usec) / 1e6; };
+#    if defined(__APPLE__)
+    (void)since_reset;
+    auto peak_rss = std::uint64_t(usage.ru_maxrss); // already in bytes
+#    elif defined(__linux__)
+    auto peak_rss = since_reset ? get_reset_peak_rss() : std::uint64_t(usage.ru_maxrss) * 1024u;
+#    else
+    (void)since_reset;
+    auto peak_rss = std::uint64_t(usage.ru_maxrss) * 1024u;
+#    endif
+    return {to_seconds(usage.ru_utime) + to_seconds(usage.ru_stime), peak_rss};
+#else
+    (void)since_reset;
+    return {0.0, 0u};
+#endif
+}
+} // namespace
+
+run_statistics::run_statistics() : cur_cpu_(0.0), in_phase_(false), run_peak_(reset_peak_rss())
+{}
+
+void run_statistics::start_phase(std::string name)
+{
+    end_phase();
+
+    cur_name_  = std::move(name);
+    cur_start_ = std::chrono::steady_clock::now();
+    cur_cpu_   = get_resource_usage(run_peak_).cpu_seconds;
+    in_phase_  = true;
+}
+
+void run_statistics::end_phase()
+{
+    if (!in_phase_)
+        return;
+
+    auto usage = get_resource_usage(run_peak_);
+    auto wall  = std::chrono::duration<double>(std::chrono::steady_clock::now() - cur_start_);
+    phases_.push_back({std::move(cur_name_), wall.count(), usage.cpu_seconds - cur_cpu_,
+                       usage.peak_rss_bytes});
+    in_phase_ = false;
+}
+
+void run_statistics::add_counters(const documents& docs)
+{
+    std::uint64_t entities = 0u, documentations = 0u, links = 0u, unresolved = 0u;
+    for (auto& doc : docs)
+        standardese::markup::visit(*doc, [&](const standardese::markup::entity& e) {
+            switch (e.kind())
+            {
+            case standardese::markup::entity_kind::entity_documentation:
+                ++entities;
+                ++documentations;
+                break;
+            case standardese::markup::entity_kind::file_documentation:
+            case standardese::markup::entity_kind::namespace_documentation:
+            case standardese::markup::entity_kind::module_documentation:
+                ++documentations;
+                break;
+
+            case standardese::markup::entity_kind::documentation_link:
+                ++links;
+                if (static_cast<const standardese::markup::documentation_link&>(e)
+                        .unresolved_destination())
+                    ++unresolved;
+                break;
+
+            default:
+                break;
+            }
+        });
+
+    add_counter("documents", docs.size());
+    add_counter("entities", entities);
+    add_counter("documentations", documentations);
+    add_counter("links", links);
+    add_counter("unresolved_links", unresolved);
+}
+
+void run_statistics::write(const fs::path& file) const
+{
+    std::ofstream out(file.string());
+    if (!out.is_open())
+        throw std::runtime_error("unable to write statistics to '" + file.generic_string() + "'");
+    out << std::fixed << std::setprecision(6);
+    auto peak_name = run_peak_ ? "peak_rss_bytes" : "process_peak_rss_bytes";
+
+    if (file.extension() == ".csv")
+    {
+        out << "metric,value\n";
+        for (auto& phase : phases_)
+        {
+            out << "phase." << phase.name << ".wall_seconds," << phase.wall_seconds << '\n';
+            out << "phase." << phase.name << ".cpu_seconds," << phase.cpu_seconds << '\n';
+            out << "phase." << phase.name << '.' << peak_name << ',' << phase.peak_rss_bytes
+                << '\n';
+        }
+        for (auto& counter : counters_)
+            out << counter.first << ',' << counter.second << '\n';
+    }
+    else
+    {
+        // the names are all identifiers, so they don't need escaping
+        out << "{\n  \"phases\": [";
+        for (auto i = std::size_t(0); i != phases_.size(); ++i)
+        {
+            auto& phase = phases_[i];
+            out << (i == 0u ? "\n" : ",\n") << "    {\"name\": \"" << phase.name
+                << "\", \"wall_seconds\": " << phase.wall_seconds
+                << ", \"cpu_seconds\": " << phase.cpu_seconds
+                << ", \"" << peak_name << "\": " << phase.peak_rss_bytes << '}';
+        }
+        out << "\n  ],\n  \"counters\": {";
+        for (auto i = std::size_t(0); i != counters_.size(); ++i)
+            out << (i == 0u ? "\n" : ",\n") << "    \"" << counters_[i].first
+                << "\": " << counters_[i].second;
+        out << "\n  }\n}\n";
+    }
+}
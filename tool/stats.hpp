@@ -0,0 +1,68 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_STATS_HPP_INCLUDED
+#define STANDARDESE_TOOL_STATS_HPP_INCLUDED
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "filesystem.hpp"
+#include "generator.hpp"
+
+namespace standardese_tool
+{
+// the statistics of a run
+//
+// It measures wall and CPU time of each phase and the peak memory usage after it,
+// as well as arbitrary counters.
+// On Linux the peak memory usage is reset when the statistics are created,
+// so it is the peak of the run, even in watch mode;
+// elsewhere it is the peak of the whole process and reported as such.
+class run_statistics
+{
+public:
+    run_statistics();
+
+    // ends the current phase, if any, and starts a new one
+    void start_phase(std::string name);
+
+    // ends the current phase, if any
+    void end_phase();
+
+    void add_counter(std::string name, std::uint64_t value)
+    {
+        counters_.emplace_back(std::move(name), value);
+    }
+
+    // adds counters for the entities and links in the documents
+    void add_counters(const documents& docs);
+
+    // writes the statistics to the file
+    // it is written as CSV if the extension is `.csv`, as JSON otherwise
+    void write(const fs::path& file) const;
+
+private:
+    struct phase
+    {
+        std::string   name;
+        double        wall_seconds, cpu_seconds;
+        std::uint64_t peak_rss_bytes;
+    };
+
+    std::vector<phase>                                 phases_;
+    std::vector<std::pair<std::string, std::uint64_t>> counters_;
+
+    std::string                           cur_name_;
+    std::chrono::steady_clock::time_point cur_start_;
+    double                                cur_cpu_;
+    bool                                  in_phase_;
+    bool                                  run_peak_; // whether the peak has been reset
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_STATS_HPP_INCLUDED
@@ -0,0 +1,126 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "trace.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+using namespace standardese_tool;
+
+std::atomic<bool> standardese_tool::detail::tracing_enabled(false);
+
+namespace
+{
+struct trace_event
+{
+    const char*  name;
+    std::string  arg;
+    std::int64_t start, duration; // in microseconds
+};
+
+// the events of one thread, so recording doesn't need synchronization
+struct trace_buffer
+{
+    unsigned                 tid;
+    std::vector<trace_event> events;
+};
+
+std::chrono::steady_clock::time_point      trace_start;
+std::mutex                                 buffers_mutex;
+std::vector<std::unique_ptr<trace_buffer>> buffers;
+thread_local trace_buffer*                 current_buffer = nullptr;
+
+std::int64_t now()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now()
+                                                                 - trace_start)
+        .count();
+}
+
+trace_buffer& get_buffer()
+{
+    if (!current_buffer)
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+        buffers.emplace_back(new trace_buffer{unsigned(buffers.size()), {}});
+        current_buffer = buffers.back().get();
+    }
+    return *current_buffer;
+}
+
+void write_string(std::ostream& out, const std::string& str)
+{
+    out << '"';
+    for (auto c : str)
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20)
+            out << ' ';
+        else
+            out << c;
+    out << '"';
+}
+} // namespace
+
+void standardese_tool::enable_tracing()
+{
+    trace_start = std::chrono::steady_clock::now();
+    detail::tracing_enabled = true;
+}
+
+void standardese_tool::write_trace(const fs::path& file)
+{
+    std::ofstream out(file.string());
+    if (!out.is_open())
+        throw std::runtime_error("unable to write trace to '" + file.generic_string() + "'");
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+
+    out << "{\"traceEvents\":[";
+    auto first = true;
+    for (auto& buffer : buffers)
+    {
+        for (auto& event : buffer->events)
+        {
+            out << (first ? "\n" : ",\n");
+            first = false;
+
+            out << "{\"name\":\"" << event.name << "\",\"cat\":\"standardese\",\"ph\":\"X\",\"ts\":"
+                << event.start << ",\"dur\":" << event.duration << ",\"pid\":1,\"tid\":"
+                << buffer->tid;
+            if (!event.arg.empty())
+            {
+                out << ",\"args\":{\"file\":";
+                write_string(out, event.arg);
+                out << '}';
+            }
+            out << '}';
+        }
+        buffer->events.clear();
+    }
+    out << "\n]}\n";
+}
+
+void trace_scope::start() noexcept
+{
+    start_ = now();
+}
+
+void trace_scope::finish() noexcept
+{
+    try
+    {
+        auto end = now();
+        get_buffer().events.push_back({name_, std::move(arg_), start_, end - start_});
+    }
+    catch (...)
+    {
+        // lose the event rather than the run
+    }
+}
@@ -0,0 +1,67 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_TRACE_HPP_INCLUDED
+#define STANDARDESE_TOOL_TRACE_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "filesystem.hpp"
+
+namespace standardese_tool
+{
+namespace detail
+{
+    extern std::atomic<bool> tracing_enabled;
+} // namespace detail
+
+// starts recording trace events
+void enable_tracing();
+
+// writes all recorded events in the Chrome trace event format and clears them
+// must not be called while events are recorded
+void write_trace(const fs::path& file);
+
+// records the time between construction and destruction as a span of the current thread
+// it does nothing if tracing is not enabled
+class trace_scope
+{
+public:
+    explicit trace_scope(const char* name) noexcept
+    : name_(name), start_(0), active_(detail::tracing_enabled.load(std::memory_order_relaxed))
+    {
+        if (active_)
+            start();
+    }
+
+    // the argument is shown in the details of the span, e.g. the file name
+    trace_scope(const char* name, const std::string& arg) : trace_scope(name)
+    {
+        if (active_)
+            arg_ = arg;
+    }
+
+    trace_scope(const trace_scope&) = delete;
+    trace_scope& operator=(const trace_scope&) = delete;
+
+    ~trace_scope() noexcept
+    {
+        if (active_)
+            finish();
+    }
+
+private:
+    void start() noexcept;
+    void finish() noexcept;
+
+    const char*  name_;
+    std::string  arg_;
+    std::int64_t start_;
+    bool         active_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_TRACE_HPP_INCLUDED
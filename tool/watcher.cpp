@@ -0,0 +1,239 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#include "watcher.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+#if defined(__linux__)
+#    include <cerrno>
+#    include <poll.h>
+#    include <sys/inotify.h>
+#    include <unistd.h>
+#endif
+
+using namespace standardese_tool;
+
+#if defined(__linux__)
+
+namespace
+{
+const auto watch_mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                        | IN_DELETE_SELF | IN_MOVE_SELF;
+}
+
+file_watcher::file_watcher(const std::vector<fs::path>& paths, input_filter filter)
+: paths_(paths), filter_(std::move(filter)), fd_(inotify_init1(IN_CLOEXEC))
+{
+    if (fd_ < 0)
+        throw std::runtime_error("unable to initialize inotify");
+
+    try
+    {
+        for (auto& path : paths_)
+            add_path(path);
+    }
+    catch (...)
+    {
+        close(fd_);
+        throw;
+    }
+}
+
+file_watcher::~file_watcher()
+{
+    close(fd_);
+}
+
+void file_watcher::wait(std::chrono::milliseconds debounce)
+{
+    pollfd fd = {fd_, POLLIN, 0};
+    while (true)
+    {
+        if (poll(&fd, 1, -1) < 0 && errno != EINTR)
+            throw std::runtime_error("unable to wait for file changes");
+        else if ((fd.revents & POLLIN) != 0 && read_events())
+            break;
+    }
+
+    // wait until it settles
+    while (poll(&fd, 1, int(debounce.count())) > 0)
+        read_events();
+}
+
+void file_watcher::add_path(const fs::path& path)
+{
+    boost::system::error_code ec;
+    if (fs::is_directory(path, ec))
+        add_directory(path, fs::path());
+    else
+        add_file(path);
+}
+
+void file_watcher::add_directory(const fs::path& directory, const fs::path& relative)
+{
+    auto wd = inotify_add_watch(fd_, directory.string().c_str(), watch_mask);
+    if (wd < 0)
+        throw std::runtime_error("unable to watch '" + directory.generic_string() + "'");
+    // a directory watched because of a file is now watched completely
+    watches_[wd] = {directory, relative, {}};
+
+    // like scanning the inputs: blacklisted directories are pruned and symlinks aren't followed
+    // directories that are removed or unreadable in the meantime are skipped
+    std::vector<std::pair<fs::path, fs::path>> pending = {{directory, relative}};
+    while (!pending.empty())
+    {
+        auto cur = std::move(pending.back());
+        pending.pop_back();
+
+        boost::system::error_code ec;
+        for (fs::directory_iterator iter(cur.first, ec), end; !ec && iter != end;
+             iter.increment(ec))
+        {
+            boost::system::error_code status_ec;
+            if (!fs::is_directory(iter->symlink_status(status_ec)) || status_ec)
+                continue;
+
+            auto path     = iter->path();
+            auto rel_path = cur.second / path.filename();
+            if (!filter_.is_valid(path, rel_path, true))
+                continue;
+
+            wd = inotify_add_watch(fd_, path.string().c_str(), watch_mask);
+            if (wd >= 0)
+            {
+                watches_[wd] = {path, rel_path, {}};
+                pending.emplace_back(std::move(path), std::move(rel_path));
+            }
+        }
+    }
+}
+
+void file_watcher::add_file(const fs::path& file)
+{
+    // watch the directory, editors replace files instead of modifying them
+    auto directory = file.has_parent_path() ? file.parent_path() : fs::path(".");
+    auto wd        = inotify_add_watch(fd_, directory.string().c_str(), watch_mask);
+    if (wd < 0)
+        throw std::runtime_error("unable to watch '" + file.generic_string() + "'");
+
+    auto name = file.filename().string();
+    auto iter = watches_.find(wd);
+    if (iter == watches_.end())
+        watches_[wd] = {directory, fs::path(), {name}};
+    else if (!iter->second.files.empty()
+             && std::find(iter->second.files.begin(), iter->second.files.end(), name)
+                    == iter->second.files.end())
+        iter->second.files.push_back(name);
+}
+
+bool file_watcher::read_events()
+{
+    alignas(inotify_event) char buffer[4096];
+    auto                        size = read(fd_, buffer, sizeof(buffer));
+    if (size <= 0)
+        return false;
+
+    auto changed = false, overflow = false;
+    for (auto ptr = buffer; ptr < buffer + size;)
+    {
+        auto& event = *reinterpret_cast<const inotify_event*>(ptr);
+        ptr += sizeof(inotify_event) + event.len;
+
+        if ((event.mask & IN_Q_OVERFLOW) != 0)
+        {
+            // events have been lost, including creation of directories that need a watch
+            overflow = true;
+            continue;
+        }
+
+        auto iter = watches_.find(event.wd);
+        if (iter == watches_.end())
+            continue;
+        else if ((event.mask & IN_IGNORED) != 0)
+        {
+            // watch removed
+            watches_.erase(iter);
+            continue;
+        }
+
+        auto& watch = iter->second;
+        auto  name  = event.len > 0u ? std::string(event.name) : std::string();
+        if (!watch.files.empty())
+        {
+            if (std::find(watch.files.begin(), watch.files.end(), name) != watch.files.end())
+                changed = true;
+        }
+        else if (name.empty())
+            // the directory itself has been removed or moved
+            changed = true;
+        else if ((event.mask & IN_ISDIR) != 0)
+        {
+            auto path     = watch.directory / name;
+            auto relative = watch.relative / name;
+            if (!filter_.is_valid(path, relative, true))
+                // e.g. a build directory inside the sources
+                continue;
+            else if ((event.mask & (IN_CREATE | IN_MOVED_TO)) != 0)
+            {
+                // watch new directories as well
+                try
+                {
+                    add_directory(path, relative);
+                }
+                catch (std::exception&)
+                {
+                    // already removed again
+                }
+            }
+            changed = true;
+        }
+        else if (filter_.is_valid(watch.directory / name, watch.relative / name, false))
+            // every file that isn't blacklisted is an input
+            changed = true;
+    }
+
+    if (overflow)
+    {
+        // watch everything again, a full run is needed anyway
+        for (auto& path : paths_)
+            try
+            {
+                add_path(path);
+            }
+            catch (std::exception&)
+            {
+                // path has been removed
+            }
+        changed = true;
+    }
+
+    return changed;
+}
+
+#else
+
+file_watcher::file_watcher(const std::vector<fs::path>&, input_filter filter)
+: filter_(std::move(filter)), fd_(-1)
+{
+    throw std::runtime_error("watching for file changes is only supported on Linux");
+}
+
+file_watcher::~file_watcher() {}
+
+void file_watcher::wait(std::chrono::milliseconds) {}
+
+void file_watcher::add_path(const fs::path&) {}
+
+void file_watcher::add_directory(const fs::path&, const fs::path&) {}
+
+void file_watcher::add_file(const fs::path&) {}
+
+bool file_watcher::read_events()
+{
+    return false;
+}
+
+#endif
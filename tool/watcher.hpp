@@ -0,0 +1,60 @@
+// Copyright (C) 2016-2019 Jonathan Müller <jonathanmueller.dev@gmail.com>
+// This file is subject to the license terms in the LICENSE file
+// found in the top-level directory of this distribution.
+
+#ifndef STANDARDESE_TOOL_WATCHER_HPP_INCLUDED
+#define STANDARDESE_TOOL_WATCHER_HPP_INCLUDED
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "filesystem.hpp"
+
+namespace standardese_tool
+{
+// watches files and directories for changes
+// it only reports that something changed, the caller runs everything again
+// only supported on Linux, where it uses inotify
+class file_watcher
+{
+public:
+    // watches the given files and directories, recursively
+    // in directories the filter applies like when scanning the inputs:
+    // blacklisted directories aren't watched and changes to blacklisted files aren't reported
+    // throws if watching is not supported
+    explicit file_watcher(const std::vector<fs::path>& paths, input_filter filter);
+
+    file_watcher(const file_watcher&) = delete;
+    file_watcher& operator=(const file_watcher&) = delete;
+
+    ~file_watcher();
+
+    // blocks until something has changed,
+    // then waits until nothing has changed for the given duration,
+    // so saving multiple files at once triggers only one run
+    // if events have been lost, it reports a change as well, so everything is generated again
+    void wait(std::chrono::milliseconds debounce);
+
+private:
+    struct watch
+    {
+        fs::path                 directory;
+        fs::path                 relative; // relative to the watched input directory
+        std::vector<std::string> files;    // empty if all files in the directory are watched
+    };
+
+    void add_path(const fs::path& path);
+    void add_directory(const fs::path& directory, const fs::path& relative);
+    void add_file(const fs::path& file);
+    bool read_events();
+
+    std::vector<fs::path>          paths_;
+    std::unordered_map<int, watch> watches_;
+    input_filter                   filter_;
+    int                            fd_;
+};
+} // namespace standardese_tool
+
+#endif // STANDARDESE_TOOL_WATCHER_HPP_INCLUDED